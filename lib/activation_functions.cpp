@@ -1,6 +1,8 @@
 #include <cmath>
+#include <cstring>
 #include <algorithm>
 #include <vector>
+#include <iostream>
 #include "activation_functions.hpp"
 
 /**
@@ -112,3 +114,275 @@ double neat::swish(double x)
     double beta = 1.0;
     return x / (1.0 + exp(-beta * x));
 }
+
+#if defined(__GNUC__)
+
+#if defined(__x86_64__) && defined(__linux__)
+// The array kernels are compiled for several instruction sets and the best one is selected at load time from the CPU features
+#define NEAT_TARGET_CLONES __attribute__((target_clones("avx512f", "avx2", "default")))
+#else
+// NEON is always available on ARM 64-bit, so there is nothing to select at runtime
+#define NEAT_TARGET_CLONES
+#endif
+
+#define NEAT_ALWAYS_INLINE inline __attribute__((always_inline))
+
+#if !defined(__clang__)
+// The vector helpers are always inlined, so the ABI used to return wide vectors doesn't matter.
+// They take their vectors by reference: GCC notes the ABI of wide vector parameters even with this warning disabled.
+#pragma GCC diagnostic ignored "-Wpsabi"
+#endif
+
+// Generic vectors of 8 doubles, lowered by the compiler to one AVX-512, two AVX2 or four SSE2/NEON registers
+constexpr size_t VECTOR_LANES = 8;
+typedef double double_vector __attribute__((vector_size(VECTOR_LANES * sizeof(double))));
+typedef std::int64_t int_vector __attribute__((vector_size(VECTOR_LANES * sizeof(double))));
+
+static NEAT_ALWAYS_INLINE double_vector splat(double value)
+{
+    return double_vector{} + value;
+}
+
+static NEAT_ALWAYS_INLINE double_vector select(const int_vector &mask, const double_vector &if_true, const double_vector &if_false)
+{
+    int_vector true_bits, false_bits;
+    std::memcpy(&true_bits, &if_true, sizeof(true_bits));
+    std::memcpy(&false_bits, &if_false, sizeof(false_bits));
+    int_vector bits = (true_bits & mask) | (false_bits & ~mask);
+
+    double_vector result;
+    std::memcpy(&result, &bits, sizeof(result));
+    return result;
+}
+
+/**
+ * @brief Vectorized exp, using exp(x) = 2^k * exp(r) with k = round(x / ln(2)) and |r| <= ln(2) / 2.
+ * exp(r) is evaluated with its Taylor polynomial of degree 13, which keeps the relative error around 1e-16.
+ * Like std::exp, it overflows to infinity above ~709.78 and underflows to subnormals then 0 below ~-708.4.
+ */
+static NEAT_ALWAYS_INLINE double_vector exp_vector(const double_vector &input)
+{
+    // Beyond this range the result is already infinity or 0, and k still fits in two exponents
+    double_vector x = select(input < -746.0, splat(-746.0), input);
+    x = select(x > 710.0, splat(710.0), x);
+
+    // Adding 1.5 * 2^52 rounds to the nearest integer, which is then found in the low bits of the mantissa
+    const double_vector shifter = splat(6755399441055744.0);
+    double_vector k = x * 1.4426950408889634 + shifter;
+    int_vector k_bits, shifter_bits;
+    std::memcpy(&k_bits, &k, sizeof(k_bits));
+    std::memcpy(&shifter_bits, &shifter, sizeof(shifter_bits));
+    k -= shifter;
+
+    // ln(2) is split in two parts so that k * ln(2) is exact
+    double_vector r = x - k * 6.93147180369123816490e-01 - k * 1.90821492927058770002e-10;
+
+    double_vector p = splat(1.0 / 6227020800.0);
+    p = p * r + 1.0 / 479001600.0;
+    p = p * r + 1.0 / 39916800.0;
+    p = p * r + 1.0 / 3628800.0;
+    p = p * r + 1.0 / 362880.0;
+    p = p * r + 1.0 / 40320.0;
+    p = p * r + 1.0 / 5040.0;
+    p = p * r + 1.0 / 720.0;
+    p = p * r + 1.0 / 120.0;
+    p = p * r + 1.0 / 24.0;
+    p = p * r + 1.0 / 6.0;
+    p = p * r + 0.5;
+    p = p * r + 1.0;
+    p = p * r + 1.0;
+
+    // Build 2^k from the exponent bits of two halves of k, as 2^k alone may not be a normal double.
+    // The second multiplication then overflows or goes subnormal with a single rounding, like std::exp.
+    int_vector k_int = k_bits - shifter_bits;
+    int_vector k_half = k_int >> 1;
+    int_vector scale1_bits = (k_half + 1023) << 52;
+    int_vector scale2_bits = (k_int - k_half + 1023) << 52;
+    double_vector scale1, scale2;
+    std::memcpy(&scale1, &scale1_bits, sizeof(scale1));
+    std::memcpy(&scale2, &scale2_bits, sizeof(scale2));
+    return p * scale1 * scale2;
+}
+
+static NEAT_ALWAYS_INLINE double_vector step_vector(const double_vector &x)
+{
+    return select(x > 0.0, splat(1.0), splat(0.0));
+}
+
+static NEAT_ALWAYS_INLINE double_vector sigmoid_vector(const double_vector &x)
+{
+    return 1.0 / (1.0 + exp_vector(-x));
+}
+
+static NEAT_ALWAYS_INLINE double_vector tanh_vector(const double_vector &x)
+{
+    // tanh(x) = sign(x) * (1 - exp(-2|x|)) / (1 + exp(-2|x|)), which never overflows
+    double_vector abs_x = select(x < 0.0, -x, x);
+    double_vector t = exp_vector(-2.0 * abs_x);
+    double_vector y = (1.0 - t) / (1.0 + t);
+    y = select(x < 0.0, -y, y);
+
+    // Close to 0, 1 - exp(-2|x|) cancels out, so use the Taylor series instead
+    double_vector x2 = x * x;
+    double_vector series = x * (1.0 + x2 * (-1.0 / 3.0 + x2 * (2.0 / 15.0)));
+    return select(abs_x < 0.004, series, y);
+}
+
+static NEAT_ALWAYS_INLINE double_vector relu_vector(const double_vector &x)
+{
+    return select(x > 0.0, x, splat(0.0));
+}
+
+static NEAT_ALWAYS_INLINE double_vector leaky_relu_vector(const double_vector &x)
+{
+    return select(x > 0.0, x, 0.01 * x);
+}
+
+static NEAT_ALWAYS_INLINE double_vector prelu_vector(const double_vector &x)
+{
+    return select(x > 0.0, x, 0.1 * x);
+}
+
+static NEAT_ALWAYS_INLINE double_vector elu_vector(const double_vector &x)
+{
+    return select(x > 0.0, x, exp_vector(x) - 1.0);
+}
+
+static NEAT_ALWAYS_INLINE double_vector softmax_vector(const double_vector &x)
+{
+    double_vector e = exp_vector(x);
+    return e / (1.0 + e);
+}
+
+static NEAT_ALWAYS_INLINE double_vector linear_vector(const double_vector &x)
+{
+    return x;
+}
+
+static NEAT_ALWAYS_INLINE double_vector swish_vector(const double_vector &x)
+{
+    return x / (1.0 + exp_vector(-x));
+}
+
+/**
+ * @brief Applies a vector kernel to an array, the last incomplete vector being padded with zeros.
+ */
+template <double_vector (*Kernel)(const double_vector &)>
+static NEAT_ALWAYS_INLINE void apply_kernel(const double *x, double *y, size_t n)
+{
+    size_t i = 0;
+    for (; i + VECTOR_LANES <= n; i += VECTOR_LANES)
+    {
+        double_vector v;
+        std::memcpy(&v, x + i, sizeof(v));
+        v = Kernel(v);
+        std::memcpy(y + i, &v, sizeof(v));
+    }
+
+    if (i < n)
+    {
+        double_vector v = {};
+        std::memcpy(&v, x + i, (n - i) * sizeof(double));
+        v = Kernel(v);
+        std::memcpy(y + i, &v, (n - i) * sizeof(double));
+    }
+}
+
+#define NEAT_DEFINE_ARRAY_KERNEL(name)                                           \
+    NEAT_TARGET_CLONES void neat::name##_n(const double *x, double *y, size_t n) \
+    {                                                                            \
+        apply_kernel<name##_vector>(x, y, n);                                    \
+    }
+
+#else
+
+// Scalar fallback for compilers without generic vector extensions
+#define NEAT_DEFINE_ARRAY_KERNEL(name)                            \
+    void neat::name##_n(const double *x, double *y, size_t n)     \
+    {                                                             \
+        for (size_t i = 0; i < n; ++i)                            \
+        {                                                         \
+            y[i] = neat::name(x[i]);                              \
+        }                                                         \
+    }
+
+#endif
+
+NEAT_DEFINE_ARRAY_KERNEL(step)
+NEAT_DEFINE_ARRAY_KERNEL(sigmoid)
+NEAT_DEFINE_ARRAY_KERNEL(tanh)
+NEAT_DEFINE_ARRAY_KERNEL(relu)
+NEAT_DEFINE_ARRAY_KERNEL(leaky_relu)
+NEAT_DEFINE_ARRAY_KERNEL(prelu)
+NEAT_DEFINE_ARRAY_KERNEL(elu)
+NEAT_DEFINE_ARRAY_KERNEL(softmax)
+NEAT_DEFINE_ARRAY_KERNEL(linear)
+NEAT_DEFINE_ARRAY_KERNEL(swish)
+
+// Dispatch table, indexed by the ActivationFunction enum
+static const neat::ActivationFunctionPointer activation_functions_table[neat::ACTIVATION_FUNCTIONS_COUNT] = {
+    neat::step,
+    neat::sigmoid,
+    neat::tanh,
+    neat::relu,
+    neat::leaky_relu,
+    neat::prelu,
+    neat::elu,
+    neat::softmax,
+    neat::linear,
+    neat::swish};
+
+// Array versions of the activation functions, indexed by the ActivationFunction enum
+static void (*const array_activation_functions_table[neat::ACTIVATION_FUNCTIONS_COUNT])(const double *, double *, size_t) = {
+    neat::step_n,
+    neat::sigmoid_n,
+    neat::tanh_n,
+    neat::relu_n,
+    neat::leaky_relu_n,
+    neat::prelu_n,
+    neat::elu_n,
+    neat::softmax_n,
+    neat::linear_n,
+    neat::swish_n};
+
+// Names of the activation functions, indexed by the ActivationFunction enum
+static const char *activation_functions_names[neat::ACTIVATION_FUNCTIONS_COUNT] = {
+    "step",
+    "sigmoid",
+    "tanh",
+    "relu",
+    "leaky_relu",
+    "prelu",
+    "elu",
+    "softmax",
+    "linear",
+    "swish"};
+
+neat::ActivationFunctionPointer neat::get_activation_function(neat::ActivationFunction function)
+{
+    return activation_functions_table[static_cast<int>(function)];
+}
+
+void neat::activate_n(neat::ActivationFunction function, const double *x, double *y, size_t n)
+{
+    array_activation_functions_table[static_cast<int>(function)](x, y, n);
+}
+
+neat::ActivationFunction neat::activation_function_from_string(const std::string &name)
+{
+    for (int i = 0; i < ACTIVATION_FUNCTIONS_COUNT; ++i)
+    {
+        if (name == activation_functions_names[i])
+        {
+            return static_cast<ActivationFunction>(i);
+        }
+    }
+
+    std::cerr << "Unknown activation function: " << name << std::endl;
+    return ActivationFunction::SIGMOID;
+}
+
+std::string neat::activation_function_to_string(neat::ActivationFunction function)
+{
+    return activation_functions_names[static_cast<int>(function)];
+}
@@ -2,11 +2,35 @@
 #define NEAT_ACTIVATION_FUNCTIONS_HPP
 
 #include <string>
+#include <cstddef>
+#include <cstdint>
 
 namespace neat
 {
-    // Type alias for activation function
-    using ActivationFunction = std::string;
+    /**
+     * @brief Identifies an activation function, stored in a single byte per node.
+     *
+     * The names used in configuration files and JSON are only converted at those boundaries.
+     */
+    enum class ActivationFunction : std::uint8_t
+    {
+        STEP,
+        SIGMOID,
+        TANH,
+        RELU,
+        LEAKY_RELU,
+        PRELU,
+        ELU,
+        SOFTMAX,
+        LINEAR,
+        SWISH
+    };
+
+    // Number of values of the ActivationFunction enum
+    constexpr int ACTIVATION_FUNCTIONS_COUNT = 10;
+
+    // Type alias for the function pointer
+    using ActivationFunctionPointer = double (*)(double);
 
     double step(double x);
     double sigmoid(double x);
@@ -18,6 +42,51 @@ namespace neat
     double softmax(double x);
     double linear(double x);
     double swish(double x);
+
+    // Array versions of the activation functions: y[i] = f(x[i]) for i in [0, n), x and y may be the same buffer.
+    // They use vector instructions and a polynomial approximation of exp, and agree with the scalar functions to about 1e-14
+    // in relative error, infinities, NaNs and underflows included. Close to 0, elu computes exp(x) - 1 in both versions,
+    // which cancels out, so they only agree to about 1e-16 in absolute error there (up to ~1e-12 relative).
+    void step_n(const double *x, double *y, size_t n);
+    void sigmoid_n(const double *x, double *y, size_t n);
+    void tanh_n(const double *x, double *y, size_t n);
+    void relu_n(const double *x, double *y, size_t n);
+    void leaky_relu_n(const double *x, double *y, size_t n);
+    void prelu_n(const double *x, double *y, size_t n);
+    void elu_n(const double *x, double *y, size_t n);
+    void softmax_n(const double *x, double *y, size_t n);
+    void linear_n(const double *x, double *y, size_t n);
+    void swish_n(const double *x, double *y, size_t n);
+
+    /**
+     * @brief Retrieves the activation function from the dispatch table.
+     * @param function Activation function identifier.
+     * @return Pointer to the activation function.
+     */
+    ActivationFunctionPointer get_activation_function(ActivationFunction function);
+
+    /**
+     * @brief Applies an activation function to an array with its vectorized version.
+     * @param function Activation function identifier.
+     * @param x Input values.
+     * @param y Output values, may be the same buffer as x.
+     * @param n Number of values.
+     */
+    void activate_n(ActivationFunction function, const double *x, double *y, size_t n);
+
+    /**
+     * @brief Parses the name of an activation function.
+     * @param name Name of the activation function, as written in configuration files.
+     * @return The activation function, sigmoid if the name is unknown.
+     */
+    ActivationFunction activation_function_from_string(const std::string &name);
+
+    /**
+     * @brief Returns the name of an activation function.
+     * @param function Activation function identifier.
+     * @return Name of the activation function, as written in configuration files.
+     */
+    std::string activation_function_to_string(ActivationFunction function);
 }
 
 #endif
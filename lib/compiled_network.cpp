@@ -0,0 +1,236 @@
+#include <iostream>
+#include <vector>
+#include <algorithm>
+#include "node.hpp"
+#include "connection_gene.hpp"
+#include "genome.hpp"
+#include "compiled_network.hpp"
+
+// Number of samples evaluated together by feed_forward_batch, chosen so that the node values of a tile stay in cache
+const int BATCH_TILE_SIZE = 256;
+
+neat::CompiledNetwork::CompiledNetwork() : inputs(0), outputs(0), nb_input_layer_nodes(0), offsets(1, 0) {}
+
+neat::CompiledNetwork::CompiledNetwork(const Genome &genome) : CompiledNetwork()
+{
+    this->compile(genome);
+}
+
+void neat::CompiledNetwork::compile(const Genome &genome)
+{
+    this->inputs = genome.inputs;
+    this->outputs = genome.outputs;
+    this->nb_input_layer_nodes = 0;
+    this->input_positions.clear();
+    this->output_positions.clear();
+    this->activations.clear();
+    this->sources.clear();
+    this->weights.clear();
+
+    // Working arrays kept between two compilations, so recompiling a network doesn't allocate once they are large enough
+    struct Edge
+    {
+        int from;
+        int to;
+        double weight;
+    };
+    static thread_local std::vector<int> order;
+    static thread_local std::vector<int> positions;
+    static thread_local std::vector<Edge> edges;
+
+    // Sort the nodes by layer, which gives a valid topological order
+    const NodeGenes &nodes = genome.nodes;
+    order.clear();
+    for (int i = 0; i < nodes.size(); ++i)
+    {
+        if (nodes.layers[i] >= 0 && nodes.layers[i] < genome.layers)
+        {
+            order.push_back(i);
+        }
+    }
+    std::stable_sort(order.begin(), order.end(), [&](int i, int j)
+                     { return nodes.layers[i] < nodes.layers[j]; });
+
+    positions.assign(nodes.size(), -1);
+    for (size_t p = 0; p < order.size(); ++p)
+    {
+        positions[order[p]] = p;
+        this->activations.push_back(nodes.activation_functions[order[p]]);
+        if (nodes.layers[order[p]] == 0)
+        {
+            ++this->nb_input_layer_nodes;
+        }
+    }
+
+    // The inputs are nodes[0] to nodes[inputs-1] and the outputs are nodes[inputs] to nodes[inputs+outputs-1]
+    for (int i = 0; i < this->inputs; ++i)
+    {
+        this->input_positions.push_back(i < nodes.size() ? positions[i] : -1);
+    }
+    for (int i = 0; i < this->outputs; ++i)
+    {
+        this->output_positions.push_back(this->inputs + i < nodes.size() ? positions[this->inputs + i] : -1);
+    }
+
+    // Collect the enabled connections going forward in the network, i.e. the ones that reach a node before it is activated
+    const ConnectionGenes &genes = genome.genes;
+    edges.clear();
+    for (int i = 0; i < genes.size(); ++i)
+    {
+        int from = positions[genes.from_nodes[i]];
+        int to = positions[genes.to_nodes[i]];
+        if (genes.enabled[i] && from != -1 && from < to && to >= this->nb_input_layer_nodes)
+        {
+            edges.push_back({from, to, genes.weights[i]});
+        }
+    }
+
+    // Group the connections by target, then by source position and gene order,
+    // which is the order in which the nodes used to propagate their outputs
+    std::stable_sort(edges.begin(), edges.end(), [](const Edge &e1, const Edge &e2)
+                     { return e1.to < e2.to || (e1.to == e2.to && e1.from < e2.from); });
+
+    this->offsets.assign(order.size() + 1, 0);
+    for (auto &e : edges)
+    {
+        ++this->offsets[e.to + 1];
+        this->sources.push_back(e.from);
+        this->weights.push_back(e.weight);
+    }
+    for (size_t i = 1; i < this->offsets.size(); ++i)
+    {
+        this->offsets[i] += this->offsets[i - 1];
+    }
+}
+
+std::vector<double> neat::CompiledNetwork::feed_forward(const std::vector<double> &input_values) const
+{
+    try
+    {
+        if (this->inputs != static_cast<int>(input_values.size()))
+        {
+            throw std::invalid_argument("The number of inputs must match the number of input nodes.");
+        }
+
+        std::vector<double> values(this->size(), 0.0);
+
+        // Set the outputs of the input nodes
+        for (int i = 0; i < this->inputs; ++i)
+        {
+            if (this->input_positions[i] != -1)
+            {
+                values[this->input_positions[i]] = input_values[i];
+            }
+        }
+
+        // Engage each node in topological order
+        for (int n = this->nb_input_layer_nodes; n < this->size(); ++n)
+        {
+            double input_sum = 0;
+            for (int c = this->offsets[n]; c < this->offsets[n + 1]; ++c)
+            {
+                input_sum += this->weights[c] * values[this->sources[c]];
+            }
+            values[n] = get_activation_function(this->activations[n])(input_sum);
+        }
+
+        std::vector<double> outs(this->outputs, 0.0);
+        for (int i = 0; i < this->outputs; ++i)
+        {
+            if (this->output_positions[i] != -1)
+            {
+                outs[i] = values[this->output_positions[i]];
+            }
+        }
+
+        return outs;
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << "An error occurred during feed forward: " << e.what() << std::endl;
+        return std::vector<double>{};
+    }
+}
+
+void neat::CompiledNetwork::feed_forward_batch(const double *input_values, double *output_values, int nb_rows) const
+{
+    if (nb_rows <= 0)
+    {
+        return;
+    }
+
+    // Node-major buffer: the values of the node at position n for the current tile are values[n * tile_size + r]
+    std::vector<double> values(this->size() * std::min(nb_rows, BATCH_TILE_SIZE));
+
+    for (int tile_start = 0; tile_start < nb_rows; tile_start += BATCH_TILE_SIZE)
+    {
+        int tile_size = std::min(nb_rows - tile_start, BATCH_TILE_SIZE);
+        const double *tile_inputs = input_values + static_cast<size_t>(tile_start) * this->inputs;
+        double *tile_outputs = output_values + static_cast<size_t>(tile_start) * this->outputs;
+        std::fill(values.begin(), values.end(), 0.0);
+
+        // Set the outputs of the input nodes
+        for (int i = 0; i < this->inputs; ++i)
+        {
+            if (this->input_positions[i] != -1)
+            {
+                double *node_values = &values[this->input_positions[i] * tile_size];
+                for (int r = 0; r < tile_size; ++r)
+                {
+                    node_values[r] = tile_inputs[r * this->inputs + i];
+                }
+            }
+        }
+
+        // Engage each node in topological order, over the whole tile
+        for (int n = this->nb_input_layer_nodes; n < this->size(); ++n)
+        {
+            double *input_sums = &values[n * tile_size];
+            for (int c = this->offsets[n]; c < this->offsets[n + 1]; ++c)
+            {
+                const double weight = this->weights[c];
+                const double *source_values = &values[this->sources[c] * tile_size];
+                for (int r = 0; r < tile_size; ++r)
+                {
+                    input_sums[r] += weight * source_values[r];
+                }
+            }
+
+            activate_n(this->activations[n], input_sums, input_sums, tile_size);
+        }
+
+        for (int i = 0; i < this->outputs; ++i)
+        {
+            for (int r = 0; r < tile_size; ++r)
+            {
+                tile_outputs[r * this->outputs + i] = this->output_positions[i] != -1 ? values[this->output_positions[i] * tile_size + r] : 0.0;
+            }
+        }
+    }
+}
+
+std::vector<double> neat::CompiledNetwork::feed_forward_batch(const std::vector<double> &input_values) const
+{
+    try
+    {
+        if (this->inputs == 0 || input_values.size() % this->inputs != 0)
+        {
+            throw std::invalid_argument("The number of values must be a multiple of the number of input nodes.");
+        }
+
+        int nb_rows = input_values.size() / this->inputs;
+        std::vector<double> outs(static_cast<size_t>(nb_rows) * this->outputs, 0.0);
+        this->feed_forward_batch(input_values.data(), outs.data(), nb_rows);
+        return outs;
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << "An error occurred during feed forward: " << e.what() << std::endl;
+        return std::vector<double>{};
+    }
+}
+
+int neat::CompiledNetwork::size() const
+{
+    return this->activations.size();
+}
@@ -0,0 +1,80 @@
+#ifndef NEAT_COMPILED_NETWORK_HPP
+#define NEAT_COMPILED_NETWORK_HPP
+
+#include <vector>
+#include "activation_functions.hpp"
+
+namespace neat
+{
+
+    class Genome; // Forward declaration
+
+    /**
+     * @brief Flat, read-only phenotype of a genome used for fast inference.
+     *
+     * The nodes are stored in topological (layer) order and the incoming connections of each node are packed
+     * in contiguous CSR-style arrays: the sources and weights of the node at position i live in
+     * [offsets[i], offsets[i + 1]). Only the enabled genes are baked in, and the input layer nodes come first.
+     */
+    class CompiledNetwork
+    {
+    public:
+        int inputs;                                          // Number of input values.
+        int outputs;                                         // Number of output values.
+        std::vector<int> input_positions;                    // Position of each input node, -1 if it is not part of the network.
+        std::vector<int> output_positions;                   // Position of each output node, -1 if it is not part of the network.
+        int nb_input_layer_nodes;                            // Number of nodes of the input layer, placed first and never activated.
+        std::vector<ActivationFunction> activations;         // Activation function of each node.
+        std::vector<int> offsets;                            // Start of the incoming connections of each node (size + 1 entries).
+        std::vector<int> sources;                            // Position of the source node of each incoming connection.
+        std::vector<double> weights;                         // Weight of each incoming connection.
+
+        CompiledNetwork();
+
+        /**
+         * @brief Compiles the network of a genome.
+         * @param genome Genome to compile.
+         */
+        CompiledNetwork(const Genome &genome);
+
+        /**
+         * @brief Recompiles the network from a genome, reusing the storage of the previous network.
+         * @param genome Genome to compile.
+         */
+        void compile(const Genome &genome);
+
+        /**
+         * @brief Performs a feed-forward operation on the compiled network.
+         * @param input_values List of double values.
+         * @return List of output values.
+         */
+        std::vector<double> feed_forward(const std::vector<double> &input_values) const;
+
+        /**
+         * @brief Performs a feed-forward operation on many samples at once.
+         *
+         * The batch is evaluated node by node, so the inner loop is a contiguous multiply-add over the samples and
+         * the activations use the vectorized array kernels (results may differ from feed_forward by about 1e-15).
+         * @param input_values Row-major buffer of nb_rows x inputs values.
+         * @param output_values Row-major buffer of nb_rows x outputs values, filled by the call.
+         * @param nb_rows Number of samples in the batch.
+         */
+        void feed_forward_batch(const double *input_values, double *output_values, int nb_rows) const;
+
+        /**
+         * @brief Performs a feed-forward operation on many samples at once.
+         * @param input_values Row-major list of N x inputs values.
+         * @return Row-major list of N x outputs values.
+         */
+        std::vector<double> feed_forward_batch(const std::vector<double> &input_values) const;
+
+        /**
+         * @brief Returns the number of nodes in the compiled network.
+         * @return Number of nodes.
+         */
+        int size() const;
+    };
+
+}
+
+#endif
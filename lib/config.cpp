@@ -2,6 +2,7 @@
 #include <sstream>
 #include <iostream>
 #include <unordered_map>
+#include <iterator>
 #include "config.hpp"
 
 // Function to load configuration from a text file
@@ -48,9 +49,17 @@ neat::Config neat::load_config(const std::string &filename)
             {
                 config.reset_on_extinction = (value == "true");
             }
+            else if (key == "num_threads")
+            {
+                config.num_threads = std::stoi(value);
+            }
+            else if (key == "fitness_cache")
+            {
+                config.fitness_cache = (value == "true");
+            }
             else if (key == "activation_default")
             {
-                config.activation_default = value;
+                config.activation_default = activation_function_from_string(value);
             }
             else if (key == "activation_mutate_rate")
             {
@@ -94,7 +103,7 @@ neat::Config neat::load_config(const std::string &filename)
             }
             else if (key == "initial_connections")
             {
-                config.initial_connections = value;
+                config.initial_connections = neat::initial_connection_from_string(value);
             }
             else if (key == "node_add_prob")
             {
@@ -114,7 +123,7 @@ neat::Config neat::load_config(const std::string &filename)
             }
             else if (key == "weight_init_type")
             {
-                config.weight_init_type = value;
+                config.weight_init_type = neat::distribution_type_from_string(value);
             }
             else if (key == "weight_max_value")
             {
@@ -152,6 +161,14 @@ neat::Config neat::load_config(const std::string &filename)
             {
                 config.min_species_size = std::stoi(value);
             }
+            else if (key == "selection_type")
+            {
+                config.selection_type = neat::selection_type_from_string(value);
+            }
+            else if (key == "tournament_size")
+            {
+                config.tournament_size = std::stoi(value);
+            }
             else if (key == "compatibility_threshold")
             {
                 config.compatibility_threshold = std::stod(value);
@@ -172,3 +189,69 @@ neat::Config neat::load_config(const std::string &filename)
 
     return config;
 }
+
+// Names of the selection types, in the order of the enum
+static const char *selection_types_names[] = {"roulette", "tournament", "rank"};
+
+neat::SelectionType neat::selection_type_from_string(const std::string &name)
+{
+    for (size_t i = 0; i < std::size(selection_types_names); ++i)
+    {
+        if (name == selection_types_names[i])
+        {
+            return static_cast<SelectionType>(i);
+        }
+    }
+
+    std::cerr << "Unknown selection type: " << name << std::endl;
+    return SelectionType::ROULETTE;
+}
+
+std::string neat::selection_type_to_string(neat::SelectionType selection_type)
+{
+    return selection_types_names[static_cast<int>(selection_type)];
+}
+
+// Names of the initial connection types, in the order of the enum
+static const char *initial_connections_names[] = {"none", "full"};
+
+neat::InitialConnection neat::initial_connection_from_string(const std::string &name)
+{
+    for (size_t i = 0; i < std::size(initial_connections_names); ++i)
+    {
+        if (name == initial_connections_names[i])
+        {
+            return static_cast<InitialConnection>(i);
+        }
+    }
+
+    std::cerr << "Unknown initial connection type: " << name << std::endl;
+    return InitialConnection::NONE;
+}
+
+std::string neat::initial_connection_to_string(neat::InitialConnection initial_connection)
+{
+    return initial_connections_names[static_cast<int>(initial_connection)];
+}
+
+// Names of the weight distributions, in the order of the enum
+static const char *distribution_types_names[] = {"normal", "uniform"};
+
+neat::DistributionType neat::distribution_type_from_string(const std::string &name)
+{
+    for (size_t i = 0; i < std::size(distribution_types_names); ++i)
+    {
+        if (name == distribution_types_names[i])
+        {
+            return static_cast<DistributionType>(i);
+        }
+    }
+
+    std::cerr << "Unknown weight distribution: " << name << std::endl;
+    return DistributionType::NORMAL;
+}
+
+std::string neat::distribution_type_to_string(neat::DistributionType distribution_type)
+{
+    return distribution_types_names[static_cast<int>(distribution_type)];
+}
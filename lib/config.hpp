@@ -6,9 +6,33 @@
 
 namespace neat
 {
-    // Type aliases for readability
-    using InitialConnection = std::string;
-    using DistributionType = std::string;
+    /**
+     * @brief Connections of the genomes of a new population.
+     */
+    enum class InitialConnection
+    {
+        NONE, // Only the connections added by a first mutation.
+        FULL  // Each layer fully connected to the next one.
+    };
+
+    /**
+     * @brief Distributions from which the weights of new connections are drawn.
+     */
+    enum class DistributionType
+    {
+        NORMAL, // Normal distribution of mean weight_init_mean and deviation weight_init_stdev, clamped to the bounds.
+        UNIFORM // Uniform distribution between weight_min_value and weight_max_value.
+    };
+
+    /**
+     * @brief Strategies used to select the parents of a child within a species.
+     */
+    enum class SelectionType
+    {
+        ROULETTE,   // Proportionate to the fitness of the genome.
+        TOURNAMENT, // Fittest of tournament_size genomes drawn at random.
+        RANK        // Proportionate to the rank of the genome in its species.
+    };
 
     /**
      * @brief Configuration parameters for the NEAT (NeuroEvolution of Augmenting Topologies) algorithm.
@@ -26,6 +50,10 @@ namespace neat
         bool no_fitness_termination;
         // If this evaluates to True, when all species simultaneously become extinct due to stagnation, a new random population will be created.
         bool reset_on_extinction;
+        // Number of worker threads used to evaluate, speciate and reproduce the genomes, 0 to use one per hardware thread.
+        int num_threads = 0;
+        // If true, a genome identical to a genome of the previous generation reuses its fitness instead of being evaluated again. Only for deterministic evaluators.
+        bool fitness_cache = false;
 
         // ======== GENOME =========== //
         ActivationFunction activation_default;
@@ -39,12 +67,12 @@ namespace neat
         double conn_delete_prob;
         bool enabled_default;
         double enabled_mutate_rate;
-        InitialConnection initial_connections;
+        InitialConnection initial_connections = InitialConnection::NONE;
         double node_add_prob;
         double node_delete_prob;
         double weight_init_mean;
         double weight_init_stdev;
-        DistributionType weight_init_type;
+        DistributionType weight_init_type = DistributionType::NORMAL;
         double weight_max_value;
         double weight_min_value;
         double weight_mutate_rate;
@@ -63,6 +91,10 @@ namespace neat
         double survival_threshold;
         // The minimum number of genomes per species after reproduction.
         int min_species_size;
+        // How the parents of a child are selected within its species.
+        SelectionType selection_type = SelectionType::ROULETTE;
+        // The number of genomes competing for each selection when selection_type is tournament.
+        int tournament_size = 3;
 
         // ======== SPECIES =========== //
         // Individuals whose genomic distance is less than this threshold are considered to be in the same species.
@@ -78,6 +110,48 @@ namespace neat
      */
     Config load_config(const std::string &filename);
 
+    /**
+     * @brief Converts a string to a selection type.
+     * @param name Name of the selection type.
+     * @return Selection type, roulette if the name is unknown.
+     */
+    SelectionType selection_type_from_string(const std::string &name);
+
+    /**
+     * @brief Converts a selection type to a string.
+     * @param selection_type Selection type.
+     * @return Name of the selection type.
+     */
+    std::string selection_type_to_string(SelectionType selection_type);
+
+    /**
+     * @brief Converts a string to an initial connection type.
+     * @param name Name of the initial connection type.
+     * @return Initial connection type, none if the name is unknown.
+     */
+    InitialConnection initial_connection_from_string(const std::string &name);
+
+    /**
+     * @brief Converts an initial connection type to a string.
+     * @param initial_connection Initial connection type.
+     * @return Name of the initial connection type.
+     */
+    std::string initial_connection_to_string(InitialConnection initial_connection);
+
+    /**
+     * @brief Converts a string to a weight distribution type.
+     * @param name Name of the distribution.
+     * @return Distribution type, normal if the name is unknown.
+     */
+    DistributionType distribution_type_from_string(const std::string &name);
+
+    /**
+     * @brief Converts a weight distribution type to a string.
+     * @param distribution_type Distribution type.
+     * @return Name of the distribution.
+     */
+    std::string distribution_type_to_string(DistributionType distribution_type);
+
 }
 
 #endif
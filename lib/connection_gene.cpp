@@ -1,45 +1,219 @@
-#include <iostream>
+#include <algorithm>
+#include <numeric>
 #include "math_utils.hpp"
 #include "config.hpp"
-#include "node.hpp"
 #include "connection_gene.hpp"
-#include <memory>
 
-neat::ConnectionGene::ConnectionGene(std::shared_ptr<Node> from, std::shared_ptr<Node> to, double w, int innovation, bool enabled) : from_node(from), to_node(to), weight(w), innovation_nb(innovation), enabled(enabled) {}
+int neat::ConnectionGenes::size() const
+{
+    return this->innovation_nbs.size();
+}
 
-neat::ConnectionGene::~ConnectionGene()
+bool neat::ConnectionGenes::contains(int from, int to) const
 {
-    this->from_node.reset();
-    this->to_node.reset();
+    return (this->connected_targets(from, to / 64) >> (to % 64)) & 1;
 }
 
-void neat::ConnectionGene::mutate(const neat::Config &config)
+std::uint64_t neat::ConnectionGenes::connected_targets(int from, int word) const
 {
-    // Change the weight of the connection or disable/enable it
-    if (randrange() < config.weight_replace_rate)
+    if (from < 0 || word < 0 || from >= 64 * this->connected_stride || word >= this->connected_stride)
     {
-        this->weight = uniform(config.weight_min_value, config.weight_max_value);
+        return 0;
     }
-    else if (randrange() < config.weight_mutate_rate)
+    return this->connected[static_cast<size_t>(from) * this->connected_stride + word];
+}
+
+void neat::ConnectionGenes::set_connected(int from, int to)
+{
+    int largest = std::max(from, to);
+    if (largest >= 64 * this->connected_stride)
     {
-        // Otherwise, slightly change it
-        this->weight += normal(config.weight_init_mean, config.weight_init_stdev) / 50;
-        // Keep weight between bounds
-        this->weight = std::min(std::max(weight, config.weight_min_value), config.weight_max_value);
+        // Double the number of nodes covered, so that growing the network rebuilds the matrix only a few times
+        this->connected_stride = std::max(2 * this->connected_stride, largest / 64 + 1);
+        this->update_connected();
     }
+    this->connected[static_cast<size_t>(from) * this->connected_stride + to / 64] |= std::uint64_t(1) << (to % 64);
+}
 
-    if (randrange() < config.enabled_mutate_rate)
+void neat::ConnectionGenes::update_connected()
+{
+    this->connected.assign(static_cast<size_t>(64) * this->connected_stride * this->connected_stride, 0);
+    for (int i = 0; i < this->size(); ++i)
     {
-        this->enabled = !this->enabled;
+        int from = this->from_nodes[i];
+        int to = this->to_nodes[i];
+        this->connected[static_cast<size_t>(from) * this->connected_stride + to / 64] |= std::uint64_t(1) << (to % 64);
     }
 }
 
-bool neat::ConnectionGene::is_equal(std::shared_ptr<ConnectionGene> other)
+void neat::ConnectionGenes::add(int from, int to, double w, int innovation, bool enabled)
 {
-    return this->from_node->id == other->from_node->id && this->to_node->id == other->to_node->id && this->weight == other->weight && this->innovation_nb == other->innovation_nb && this->enabled == other->enabled;
+    this->set_connected(from, to);
+
+    // New innovations are the most recent ones, so the gene usually goes at the end
+    if (this->innovation_nbs.empty() || this->innovation_nbs.back() <= innovation)
+    {
+        this->from_nodes.push_back(from);
+        this->to_nodes.push_back(to);
+        this->weights.push_back(w);
+        this->innovation_nbs.push_back(innovation);
+        this->enabled.push_back(enabled);
+        return;
+    }
+
+    int index = std::upper_bound(this->innovation_nbs.begin(), this->innovation_nbs.end(), innovation) - this->innovation_nbs.begin();
+    this->from_nodes.insert(this->from_nodes.begin() + index, from);
+    this->to_nodes.insert(this->to_nodes.begin() + index, to);
+    this->weights.insert(this->weights.begin() + index, w);
+    this->innovation_nbs.insert(this->innovation_nbs.begin() + index, innovation);
+    this->enabled.insert(this->enabled.begin() + index, enabled);
+}
+
+void neat::ConnectionGenes::remove(int index)
+{
+    int from = this->from_nodes[index];
+    int to = this->to_nodes[index];
+
+    this->from_nodes.erase(this->from_nodes.begin() + index);
+    this->to_nodes.erase(this->to_nodes.begin() + index);
+    this->weights.erase(this->weights.begin() + index);
+    this->innovation_nbs.erase(this->innovation_nbs.begin() + index);
+    this->enabled.erase(this->enabled.begin() + index);
+
+    // The pair stays connected if another gene links the same nodes
+    for (int i = 0; i < this->size(); ++i)
+    {
+        if (this->from_nodes[i] == from && this->to_nodes[i] == to)
+        {
+            return;
+        }
+    }
+    this->connected[static_cast<size_t>(from) * this->connected_stride + to / 64] &= ~(std::uint64_t(1) << (to % 64));
+}
+
+void neat::ConnectionGenes::remove_node(int node)
+{
+    int kept = 0;
+    for (int i = 0; i < this->size(); ++i)
+    {
+        int from = this->from_nodes[i];
+        int to = this->to_nodes[i];
+        if (from == node || to == node)
+        {
+            continue;
+        }
+
+        this->from_nodes[kept] = from > node ? from - 1 : from;
+        this->to_nodes[kept] = to > node ? to - 1 : to;
+        this->weights[kept] = this->weights[i];
+        this->innovation_nbs[kept] = this->innovation_nbs[i];
+        this->enabled[kept] = this->enabled[i];
+        ++kept;
+    }
+
+    this->from_nodes.resize(kept);
+    this->to_nodes.resize(kept);
+    this->weights.resize(kept);
+    this->innovation_nbs.resize(kept);
+    this->enabled.resize(kept);
+
+    // The following nodes moved down by one index
+    this->update_connected();
 }
 
-std::shared_ptr<neat::ConnectionGene> neat::ConnectionGene::clone(std::shared_ptr<Node> from, std::shared_ptr<Node> to)
+void neat::ConnectionGenes::renumber(int first_innovation_nb, const std::vector<int> &innovation_nbs)
 {
-    return std::make_shared<ConnectionGene>(from, to, this->weight, this->innovation_nb, this->enabled);
+    if (innovation_nbs.empty())
+    {
+        return;
+    }
+
+    for (auto &innovation_nb : this->innovation_nbs)
+    {
+        if (innovation_nb >= first_innovation_nb)
+        {
+            innovation_nb = innovation_nbs[innovation_nb - first_innovation_nb];
+        }
+    }
+
+    if (std::is_sorted(this->innovation_nbs.begin(), this->innovation_nbs.end()))
+    {
+        return;
+    }
+
+    // Sort the genes by their final numbers, keeping the genes with the same number in their current order
+    std::vector<int> order(this->size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&](int i, int j)
+                     { return this->innovation_nbs[i] < this->innovation_nbs[j]; });
+
+    auto reorder = [&](auto &values)
+    {
+        auto sorted = values;
+        for (size_t i = 0; i < order.size(); ++i)
+        {
+            sorted[i] = values[order[i]];
+        }
+        values.swap(sorted);
+    };
+    reorder(this->from_nodes);
+    reorder(this->to_nodes);
+    reorder(this->weights);
+    reorder(this->innovation_nbs);
+    reorder(this->enabled);
+}
+
+void neat::ConnectionGenes::clear()
+{
+    this->from_nodes.clear();
+    this->to_nodes.clear();
+    this->weights.clear();
+    this->innovation_nbs.clear();
+    this->enabled.clear();
+    std::fill(this->connected.begin(), this->connected.end(), 0);
+}
+
+void neat::ConnectionGenes::reserve(int capacity)
+{
+    this->from_nodes.reserve(capacity);
+    this->to_nodes.reserve(capacity);
+    this->weights.reserve(capacity);
+    this->innovation_nbs.reserve(capacity);
+    this->enabled.reserve(capacity);
+}
+
+void neat::ConnectionGenes::mutate(const neat::Config &config)
+{
+    // A weight is replaced with probability weight_replace_rate, otherwise slightly changed with probability weight_mutate_rate
+    double change_rate = config.weight_replace_rate + (1 - config.weight_replace_rate) * config.weight_mutate_rate;
+    double replace_share = change_rate > 0 ? config.weight_replace_rate / change_rate : 0;
+
+    // The slightly changed weights are only listed here, to draw all their perturbations at once
+    static thread_local std::vector<int> perturbed;
+    static thread_local std::vector<double> perturbations;
+    perturbed.clear();
+    for_each_sampled(this->size(), change_rate, [&](int index)
+                     {
+                         if (randrange() < replace_share)
+                         {
+                             this->weights[index] = uniform(config.weight_min_value, config.weight_max_value);
+                         }
+                         else
+                         {
+                             perturbed.push_back(index);
+                         } });
+
+    perturbations.resize(perturbed.size());
+    normal_n(perturbations.data(), perturbations.size(), config.weight_init_mean, config.weight_init_stdev);
+    for (size_t i = 0; i < perturbed.size(); ++i)
+    {
+        double &weight = this->weights[perturbed[i]];
+        weight += perturbations[i] / 50;
+        // Keep weight between bounds
+        weight = std::min(std::max(weight, config.weight_min_value), config.weight_max_value);
+    }
+
+    // Independently, a connection is disabled or enabled again with probability enabled_mutate_rate
+    for_each_sampled(this->size(), config.enabled_mutate_rate, [&](int index)
+                     { this->enabled[index] = !this->enabled[index]; });
 }
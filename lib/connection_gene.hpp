@@ -2,60 +2,114 @@
 #define NEAT_CONNECTION_GENE_HPP
 
 #include <vector>
-#include "node.hpp"
+#include <cstdint>
 #include "config.hpp"
-#include <memory>
+
 namespace neat
 {
-    class Node; // Forward declaration
 
     /**
-     * @brief Represents a connection gene in the NEAT (NeuroEvolution of Augmenting Topologies) algorithm.
+     * @brief Represents the connection genes of a genome in the NEAT (NeuroEvolution of Augmenting Topologies) algorithm,
+     * stored as parallel contiguous arrays.
+     *
+     * The gene at index i goes from the node at index from_nodes[i] to the node at index to_nodes[i] of the genome's nodes.
+     * The genes are kept sorted by innovation number, so two genomes can be compared in a single pass.
+     * A bit matrix of the connected node pairs is kept up to date by add, remove, remove_node and clear.
      */
-    class ConnectionGene
+    class ConnectionGenes
     {
     public:
-        std::shared_ptr<Node> from_node; // Pointer to the source node.
-        std::shared_ptr<Node> to_node;   // Pointer to the target node.
-        double weight;                   // Weight of the connection.
-        int innovation_nb;               // Innovation number of the connection.
-        bool enabled;                    // Flag indicating whether the connection is enabled or disabled.
+        std::vector<int> from_nodes;     // Index of the source node of each connection.
+        std::vector<int> to_nodes;       // Index of the target node of each connection.
+        std::vector<double> weights;     // Weight of each connection.
+        std::vector<int> innovation_nbs; // Innovation number of each connection.
+        std::vector<bool> enabled;       // Whether each connection is enabled or disabled.
+
+        std::vector<std::uint64_t> connected; // Bit matrix of the node pairs linked by a gene, one row of words per source node.
+        int connected_stride = 0;             // Number of words per row of the matrix, which covers 64 * connected_stride nodes.
+
+        /**
+         * @brief Returns the number of connection genes.
+         * @return Number of connection genes.
+         */
+        int size() const;
+
+        /**
+         * @brief Checks in constant time if a gene goes from a node to another.
+         * @param from Index of the source node.
+         * @param to Index of the target node.
+         * @return True if a gene goes from the source node to the target node, false otherwise.
+         */
+        bool contains(int from, int to) const;
+
+        /**
+         * @brief Returns 64 bits of the row of a node in the matrix of the connected pairs.
+         * @param from Index of the source node.
+         * @param word Index of the word in the row, the bit i stands for the target node 64 * word + i.
+         * @return Bits of the target nodes linked to the source node by a gene.
+         */
+        std::uint64_t connected_targets(int from, int word) const;
 
         /**
-         * @brief Constructor for ConnectionGene.
-         * @param from Pointer to the source node.
-         * @param to Pointer to the target node.
+         * @brief Adds a connection gene, keeping the genes sorted by innovation number.
+         * @param from Index of the source node.
+         * @param to Index of the target node.
          * @param w Weight of the connection.
          * @param innovation Innovation number of the connection.
          * @param enabled Flag indicating whether the connection is enabled or disabled.
          */
-        ConnectionGene(std::shared_ptr<Node> from, std::shared_ptr<Node> to, double w, int innovation, bool enabled);
+        void add(int from, int to, double w, int innovation, bool enabled);
+
+        /**
+         * @brief Removes a connection gene, the following genes are shifted down by one index.
+         * @param index Index of the connection gene.
+         */
+        void remove(int index);
+
+        /**
+         * @brief Removes the connection genes going from or to a node that has been removed,
+         * and shifts the indices of the nodes that followed it.
+         * @param node Index the removed node had.
+         */
+        void remove_node(int node);
+
+        /**
+         * @brief Replaces provisional innovation numbers by their final numbers, then sorts the genes again if needed.
+         * @param first_innovation_nb First provisional innovation number, the lower numbers are kept as they are.
+         * @param innovation_nbs Final innovation number of each provisional number, from first_innovation_nb on.
+         */
+        void renumber(int first_innovation_nb, const std::vector<int> &innovation_nbs);
+
+        /**
+         * @brief Removes all the connection genes, keeping the capacity of the arrays.
+         */
+        void clear();
 
         /**
-         * @brief Destructor for ConnectionGene.
+         * @brief Reserves room for a number of connection genes.
+         * @param capacity Number of connection genes.
          */
-        ~ConnectionGene();
+        void reserve(int capacity);
 
         /**
-         * @brief Mutates the connection gene based on the NEAT configuration.
+         * @brief Mutates the connection genes based on the NEAT configuration.
+         * Only the genes picked by the mutation rates are visited, so the cost follows the number of changes.
          * @param config Reference to the NEAT configuration.
          */
         void mutate(const Config &config);
 
+    private:
         /**
-         * @brief Compare two connection genes.
-         * @param other The genes to compare with it.
-         * @return True if the genes are the same and connection genes, otherwise false.
+         * @brief Marks a node pair as connected, growing the matrix if one of the nodes is beyond it.
+         * @param from Index of the source node.
+         * @param to Index of the target node.
          */
-        bool is_equal(std::shared_ptr<ConnectionGene> other);
+        void set_connected(int from, int to);
 
         /**
-         * @brief Creates a clone of the connection gene with specified source and target nodes.
-         * @param from Pointer to the new source node.
-         * @param to Pointer to the new target node.
-         * @return Pointer to the cloned ConnectionGene.
+         * @brief Rebuilds the matrix of the connected pairs from the genes.
          */
-        std::shared_ptr<ConnectionGene> clone(std::shared_ptr<Node> from, std::shared_ptr<Node> to);
+        void update_connected();
     };
 
 }
@@ -6,13 +6,20 @@
 #include <algorithm>
 #include <fstream>
 #include <filesystem>
+#include <cstdint>
+#include <cstring>
 #include "json.hpp"
 #include "math_utils.hpp"
 #include "config.hpp"
 #include "node.hpp"
 #include "connection_gene.hpp"
-#include "connection_history.hpp"
+#include "innovation_tracker.hpp"
+#include "compiled_network.hpp"
 #include "genome.hpp"
+#include "genome_arena.hpp"
+
+// Number of random node pairs tried by add_connection before counting all the pairs that can still be connected
+const int MAX_CONNECTION_ATTEMPTS = 32;
 
 std::string generate_genome_uid(int size)
 {
@@ -32,14 +39,16 @@ std::string generate_genome_uid(int size)
     return uid;
 }
 
-int next_innovation_nb = 1;
-
 neat::Genome::Genome(){};
 
-neat::Genome::Genome(const Config &config, bool crossover) : config(config), inputs(config.num_inputs), outputs(config.num_outputs), next_node(0), fitness(0)
+neat::Genome::Genome(const Config &config, bool crossover) : Genome(std::make_shared<const Config>(config), crossover) {}
+
+neat::Genome::Genome(std::shared_ptr<const Config> config, bool crossover) : config(std::move(config)), next_node(0), fitness(0)
 {
+    this->inputs = this->config->num_inputs;
+    this->outputs = this->config->num_outputs;
     this->id = generate_genome_uid(8);
-    this->layers = 2 + this->config.num_hidden_layers;
+    this->layers = 2 + this->config->num_hidden_layers;
 
     if (crossover)
     {
@@ -53,7 +62,7 @@ neat::Genome::Genome(const Config &config, bool crossover) : config(config), inp
         {
             for (int i = 0; i < inputs; ++i)
             {
-                this->nodes.push_back(std::make_shared<Node>(l * this->inputs + i, this->config.activation_default, l));
+                this->nodes.add(l * this->inputs + i, this->config->activation_default, l);
                 ++this->next_node;
             }
         }
@@ -62,36 +71,40 @@ neat::Genome::Genome(const Config &config, bool crossover) : config(config), inp
         {
             for (int i = 0; i < this->outputs; ++i)
             {
-                this->nodes.push_back(std::make_shared<Node>(l * this->inputs + i, this->config.activation_default, l));
+                this->nodes.add(l * this->inputs + i, this->config->activation_default, l);
                 ++this->next_node;
             }
         }
     }
+
+    this->generate_network();
 }
 
-neat::Genome::~Genome()
+void neat::Genome::reset(const std::shared_ptr<const Config> &config)
 {
-    // Delete all the dynamically allocated nodes
-    for (auto n : this->nodes)
-    {
-        n.reset();
-    }
-
-    // Delete all the dynamically allocated connection genes
-    for (auto g : this->genes)
-    {
-        g.reset();
-    }
+    this->config = config;
+    this->id = generate_genome_uid(8);
+    this->inputs = config->num_inputs;
+    this->outputs = config->num_outputs;
+    this->layers = 2 + this->config->num_hidden_layers;
+    this->next_node = 0;
+    this->fitness = 0;
 
-    // Clear the nodes and genes vectors
+    // Clearing keeps the capacity of the arrays, which the next genome built here will reuse
     this->nodes.clear();
     this->genes.clear();
-    this->network.clear();
 }
 
-void neat::Genome::fully_connect(std::vector<std::shared_ptr<ConnectionHistory>> innovation_history)
+void neat::Genome::fully_connect(InnovationTracker &innovation_tracker)
 {
-    int nb_layers = 2 + this->config.num_hidden_layers;
+    int nb_layers = 2 + this->config->num_hidden_layers;
+
+    // Draw the weights of all the connections at once
+    static thread_local std::vector<double> weights;
+    weights.resize((nb_layers - 2) * this->inputs * this->inputs + this->inputs * this->outputs);
+    this->new_connection_weights(weights.data(), weights.size());
+    int next_weight = 0;
+
     for (int l = 0; l < nb_layers; ++l)
     {
         int current_layer = l;
@@ -109,17 +122,16 @@ void neat::Genome::fully_connect(std::vector<std::shared_ptr<ConnectionHistory>>
                 for (int j = 0; j < this->outputs; ++j)
                 {
                     int connection_innovation_nb = this->get_innovation_number(
-                        innovation_history,
-                        this->nodes[current_layer * this->inputs + i],
-                        this->nodes[next_layer * this->inputs + j]);
-
-                    this->genes.push_back(
-                        std::make_shared<ConnectionGene>(
-                            this->nodes[current_layer * this->inputs + i],
-                            this->nodes[next_layer * this->outputs + j],
-                            new_connection_weight(),
-                            connection_innovation_nb,
-                            this->config.enabled_default));
+                        innovation_tracker,
+                        current_layer * this->inputs + i,
+                        next_layer * this->inputs + j);
+
+                    this->genes.add(
+                        current_layer * this->inputs + i,
+                        next_layer * this->outputs + j,
+                        weights[next_weight++],
+                        connection_innovation_nb,
+                        this->config->enabled_default);
                 }
             }
         }
@@ -130,221 +142,264 @@ void neat::Genome::fully_connect(std::vector<std::shared_ptr<ConnectionHistory>>
                 for (int j = 0; j < this->inputs; ++j)
                 {
                     int connection_innovation_nb = get_innovation_number(
-                        innovation_history,
-                        this->nodes[current_layer * this->inputs + i],
-                        this->nodes[next_layer * this->inputs + j]);
-
-                    this->genes.push_back(
-                        std::make_shared<ConnectionGene>(
-                            this->nodes[current_layer * this->inputs + i],
-                            this->nodes[next_layer * this->inputs + j],
-                            new_connection_weight(),
-                            connection_innovation_nb,
-                            this->config.enabled_default));
+                        innovation_tracker,
+                        current_layer * this->inputs + i,
+                        next_layer * this->inputs + j);
+
+                    this->genes.add(
+                        current_layer * this->inputs + i,
+                        next_layer * this->inputs + j,
+                        weights[next_weight++],
+                        connection_innovation_nb,
+                        this->config->enabled_default);
                 }
             }
         }
     }
 
-    connect_nodes();
+    this->generate_network();
 }
 
-std::shared_ptr<neat::Node> neat::Genome::get_node(int id)
+int neat::Genome::get_node(int id) const
 {
-    for (auto &n : this->nodes)
-    {
-        if (n->id == id)
-        {
-            return n;
-        }
-    }
-    return nullptr;
+    return this->nodes.index_of(id);
 }
 
-void neat::Genome::connect_nodes()
+bool neat::Genome::is_connected(int node1, int node2) const
 {
-    // Clear the connections for each node
-    for (auto &n : this->nodes)
+    if (this->nodes.layers[node1] == this->nodes.layers[node2])
     {
-        n->output_connections.clear();
+        return false;
     }
 
-    // Add the connections to the nodes
-    for (auto &g : this->genes)
+    // Look for a gene going from the node of the lowest layer to the other one
+    if (this->nodes.layers[node1] > this->nodes.layers[node2])
     {
-        g->from_node->output_connections.push_back(g);
+        std::swap(node1, node2);
     }
+
+    return this->genes.contains(node1, node2);
 }
 
 std::vector<double> neat::Genome::feed_forward(std::vector<double> input_values)
 {
-    try
-    {
-        if (this->inputs != static_cast<int>(input_values.size()))
-        {
-            throw std::invalid_argument("The number of inputs must match the number of input nodes.");
-        }
-
-        // Set the outputs of the input nodes
-        for (int i = 0; i < this->inputs; ++i)
-        {
-            this->nodes[i]->output_value = input_values[i];
-        }
+    return this->network.feed_forward(input_values);
+}
 
-        // Engage each node in the network
-        for (auto &n : this->network)
-        {
-            n->activate();
-            n->propagate_output();
-        }
+void neat::Genome::generate_network()
+{
+    this->network.compile(*this);
+}
 
-        // The outputs are nodes[inputs] to nodes[inputs+outputs-1]
-        std::vector<double> outs(this->outputs, 0.0);
-        for (int i = 0; i < this->outputs; ++i)
-        {
-            outs[i] = this->nodes[this->inputs + i]->output_value;
-        }
+// Mixes a value into a hash, with the finalizer of splitmix64
+static std::uint64_t hash_combine(std::uint64_t hash, std::uint64_t value)
+{
+    std::uint64_t z = hash ^ (value + 0x9e3779b97f4a7c15ULL + (hash << 6) + (hash >> 2));
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
 
-        // Reset all the nodes for the next feed forward
-        for (auto &n : this->nodes)
-        {
-            n->input_sum = 0;
-        }
+std::uint64_t neat::Genome::hash() const
+{
+    std::uint64_t hash = hash_combine(0, this->inputs);
+    hash = hash_combine(hash, this->outputs);
+    hash = hash_combine(hash, this->layers);
 
-        return outs;
-    }
-    catch (const std::exception &e)
+    for (int i = 0; i < this->nodes.size(); ++i)
     {
-        std::cerr << "An error occurred during feed forward: " << e.what() << std::endl;
-        return std::vector<double>{};
+        hash = hash_combine(hash, this->nodes.ids[i]);
+        hash = hash_combine(hash, this->nodes.layers[i]);
+        hash = hash_combine(hash, static_cast<std::uint64_t>(this->nodes.activation_functions[i]));
     }
-}
 
-void neat::Genome::generate_network()
-{
-    this->connect_nodes();
-    this->network.clear();
-
-    // For each layer, add the nodes in that layer to the network
-    for (int l = 0; l < this->layers; ++l)
+    // The genes refer to the nodes by index, and the weights are hashed bit for bit
+    for (int i = 0; i < this->genes.size(); ++i)
     {
-        for (auto &n : this->nodes)
-        {
-            if (n->layer == l)
-            {
-                this->network.push_back(n);
-            }
-        }
+        std::uint64_t weight_bits;
+        std::memcpy(&weight_bits, &this->genes.weights[i], sizeof(weight_bits));
+        hash = hash_combine(hash, this->genes.from_nodes[i]);
+        hash = hash_combine(hash, this->genes.to_nodes[i]);
+        hash = hash_combine(hash, weight_bits);
+        hash = hash_combine(hash, this->genes.innovation_nbs[i]);
+        hash = hash_combine(hash, this->genes.enabled[i]);
     }
+
+    return hash;
 }
 
-void neat::Genome::add_node(std::vector<std::shared_ptr<ConnectionHistory>> innovation_history)
+void neat::Genome::add_node(InnovationTracker &innovation_tracker)
 {
     // Pick a random connection to create a node between
-    if (this->genes.empty())
+    if (this->genes.size() == 0)
     {
-        this->add_connection(innovation_history);
+        this->add_connection(innovation_tracker);
         return;
     }
 
     int random_connection = randrange(0, this->genes.size());
-    this->genes[random_connection]->enabled = false; // Disable the connection
+    this->genes.enabled[random_connection] = false; // Disable the connection
 
-    int new_node_nb = next_node;
-    int layer = this->genes[random_connection]->from_node->layer + 1;
+    int from_node = this->genes.from_nodes[random_connection];
+    int to_node = this->genes.to_nodes[random_connection];
+    double weight = this->genes.weights[random_connection];
+    int layer = this->nodes.layers[from_node] + 1;
 
-    std::shared_ptr<Node> new_node = std::make_shared<Node>(new_node_nb, this->config.activation_default, layer);
-    this->nodes.push_back(new_node);
+    this->nodes.add(this->next_node, this->config->activation_default, layer);
+    int new_node = this->nodes.size() - 1;
     ++this->next_node;
 
     // Add a new connection to the new node with a weight of 1
-    int connection_innovation_nb = this->get_innovation_number(
-        innovation_history,
-        this->genes[random_connection]->from_node,
-        new_node);
-
-    this->genes.push_back(
-        std::make_shared<ConnectionGene>(
-            this->genes[random_connection]->from_node,
-            new_node,
-            1,
-            connection_innovation_nb,
-            this->config.enabled_default));
-
-    connection_innovation_nb = this->get_innovation_number(
-        innovation_history,
-        new_node,
-        this->genes[random_connection]->to_node);
+    int connection_innovation_nb = this->get_innovation_number(innovation_tracker, from_node, new_node);
+    this->genes.add(from_node, new_node, 1, connection_innovation_nb, this->config->enabled_default);
 
     // Add a new connection from the new node with a weight the same as the disabled connection
-    this->genes.push_back(
-        std::make_shared<ConnectionGene>(
-            new_node,
-            this->genes[random_connection]->to_node,
-            this->genes[random_connection]->weight,
-            connection_innovation_nb,
-            this->config.enabled_default));
+    connection_innovation_nb = this->get_innovation_number(innovation_tracker, new_node, to_node);
+    this->genes.add(new_node, to_node, weight, connection_innovation_nb, this->config->enabled_default);
 
     // If the layer of the new node is equal to the layer of the output node of the old connection,
     // then a new layer needs to be created
-    if (new_node->layer == this->genes[random_connection]->to_node->layer)
+    if (layer == this->nodes.layers[to_node])
     {
-        for (size_t i = 0; i < nodes.size() - 1; ++i)
+        for (int i = 0; i < new_node; ++i)
         {
             // Don't include the new node
-            if (this->nodes[i]->layer >= new_node->layer)
+            if (this->nodes.layers[i] >= layer)
             {
-                this->nodes[i]->layer += 1;
+                this->nodes.layers[i] += 1;
             }
         }
         ++this->layers;
     }
-
-    this->connect_nodes();
 }
 
 void neat::Genome::remove_node()
 {
     // Select a random node by excluding inputs, outputs
-    auto it = std::find_if(this->nodes.begin(), this->nodes.end(), [&](const std::shared_ptr<Node> n)
-                           { return n->layer != 0 && n->layer != layers - 1; });
+    auto it = std::find_if(this->nodes.layers.begin(), this->nodes.layers.end(), [&](int layer)
+                           { return layer != 0 && layer != layers - 1; });
 
-    if (it != this->nodes.end())
+    if (it != this->nodes.layers.end())
     {
-        std::shared_ptr<Node> random_node = *it;
-        this->nodes.erase(it);
+        int random_node = it - this->nodes.layers.begin();
+        int removed_layer = *it;
+        this->nodes.remove(random_node);
 
         // Remove the connections that are connected to the random node selected
-        auto removeCondition = [&](const std::shared_ptr<ConnectionGene> g)
+        this->genes.remove_node(random_node);
+
+        // Check if the layer of the node is unique
+        bool unique_layer = std::find(this->nodes.layers.begin(), this->nodes.layers.end(), removed_layer) == this->nodes.layers.end();
+
+        // If the layer is unique, then remove it
+        if (unique_layer)
+        {
+            for (int i = 0; i < this->nodes.size(); ++i)
+                if (this->nodes.layers[i] > removed_layer)
+                    this->nodes.layers[i] -= 1;
+            --this->layers;
+        }
+    }
+}
+
+// Number of set bits of a word
+static int count_bits(std::uint64_t bits)
+{
+#if defined(__GNUC__)
+    return __builtin_popcountll(bits);
+#else
+    int count = 0;
+    for (; bits != 0; bits &= bits - 1)
+    {
+        ++count;
+    }
+    return count;
+#endif
+}
+
+// Draws a pair of nodes of different layers that aren't connected yet, with all such pairs equally likely.
+// Returns false if there is none. The free pairs are counted 64 at a time from bit masks instead of being listed.
+static bool draw_free_pair(const neat::Genome &genome, int &node1, int &node2)
+{
+    int n = genome.nodes.size();
+    int words = (n + 63) / 64;
+
+    // Bits of the nodes in the layers above each layer, the nodes left outside the layers aren't part of the network
+    static thread_local std::vector<std::uint64_t> above;
+    above.assign(static_cast<size_t>(std::max(genome.layers, 1)) * words, 0);
+    for (int j = 0; j < n; ++j)
+    {
+        int layer = genome.nodes.layers[j];
+        if (layer > 0 && layer < genome.layers)
         {
-            return g->from_node == random_node || g->to_node == random_node;
-        };
+            above[static_cast<size_t>(layer - 1) * words + j / 64] |= std::uint64_t(1) << (j % 64);
+        }
+    }
+    for (int layer = genome.layers - 3; layer >= 0; --layer)
+    {
+        for (int w = 0; w < words; ++w)
+        {
+            above[static_cast<size_t>(layer) * words + w] |= above[static_cast<size_t>(layer + 1) * words + w];
+        }
+    }
 
-        this->genes.erase(std::remove_if(this->genes.begin(), this->genes.end(), removeCondition), this->genes.end());
+    // A node can be connected to the nodes above its layer that it isn't linked to yet
+    auto free_targets = [&](int node, int word)
+    {
+        return above[static_cast<size_t>(genome.nodes.layers[node]) * words + word] & ~genome.genes.connected_targets(node, word);
+    };
 
-        // Check if the layer of the node is unique
-        bool unique_layer = true;
-        for (const auto &n : this->nodes)
+    static thread_local std::vector<int> free_counts;
+    free_counts.assign(n, 0);
+    int total = 0;
+    for (int i = 0; i < n; ++i)
+    {
+        if (genome.nodes.layers[i] >= 0 && genome.nodes.layers[i] < genome.layers)
         {
-            if (n->layer == random_node->layer)
+            for (int w = 0; w < words; ++w)
             {
-                unique_layer = false;
-                break;
+                free_counts[i] += count_bits(free_targets(i, w));
             }
+            total += free_counts[i];
         }
+    }
 
-        // If the layer is unique, then remove it
-        if (unique_layer)
+    if (total == 0)
+    {
+        return false;
+    }
+
+    // Find the node, then the word and the bit of the drawn pair
+    int k = neat::randrange(0, total);
+    node1 = 0;
+    while (k >= free_counts[node1])
+    {
+        k -= free_counts[node1++];
+    }
+    for (int w = 0; w < words; ++w)
+    {
+        std::uint64_t bits = free_targets(node1, w);
+        int count = count_bits(bits);
+        if (k < count)
         {
-            for (size_t i = 0; i < this->nodes.size(); ++i)
-                if (this->nodes[i]->layer > random_node->layer)
-                    this->nodes[i]->layer -= 1;
-            --this->layers;
+            for (; k > 0; --k)
+            {
+                bits &= bits - 1;
+            }
+            int bit = 0;
+            while (!((bits >> bit) & 1))
+            {
+                ++bit;
+            }
+            node2 = 64 * w + bit;
+            return true;
         }
+        k -= count;
     }
+    return false;
 }
 
-void neat::Genome::add_connection(std::vector<std::shared_ptr<ConnectionHistory>> innovation_history)
+void neat::Genome::add_connection(InnovationTracker &innovation_tracker)
 {
     // Cannot add a connection to a fully connected network
     if (fully_connected())
@@ -354,121 +409,102 @@ void neat::Genome::add_connection(std::vector<std::shared_ptr<ConnectionHistory>
 
     auto random_connection_nodes_are_valid = [&](int rand1, int rand2)
     {
-        return (this->nodes[rand1]->layer != this->nodes[rand2]->layer) && !this->nodes[rand1]->is_connected_to(this->nodes[rand2]);
+        return this->nodes.layers[rand1] != this->nodes.layers[rand2] && !this->is_connected(rand1, rand2);
     };
 
     // Get random nodes
-    int random_node_1 = rand() % this->nodes.size();
-    int random_node_2 = rand() % this->nodes.size();
+    int random_node_1 = randrange(0, this->nodes.size());
+    int random_node_2 = randrange(0, this->nodes.size());
 
+    int attempts = 1;
     while (!random_connection_nodes_are_valid(random_node_1, random_node_2))
     {
+        if (attempts == MAX_CONNECTION_ATTEMPTS)
+        {
+            // The network is nearly full, so draw directly from the pairs that can still be connected
+            if (!draw_free_pair(*this, random_node_1, random_node_2))
+            {
+                return;
+            }
+            break;
+        }
+
         // While the random nodes are not valid, get new ones
-        random_node_1 = rand() % this->nodes.size();
-        random_node_2 = rand() % this->nodes.size();
+        random_node_1 = randrange(0, this->nodes.size());
+        random_node_2 = randrange(0, this->nodes.size());
+        ++attempts;
     }
 
-    int temp;
-    if (this->nodes[random_node_1]->layer > this->nodes[random_node_2]->layer)
+    if (this->nodes.layers[random_node_1] > this->nodes.layers[random_node_2])
     {
         // If the first random node is after the second, then switch
-        temp = random_node_2;
-        random_node_2 = random_node_1;
-        random_node_1 = temp;
+        std::swap(random_node_1, random_node_2);
     }
 
     // Get the innovation number of the connection
     // This will be a new number if no identical genome has mutated in the same way
-    int connection_innovation_nb = this->get_innovation_number(
-        innovation_history,
-        this->nodes[random_node_1],
-        this->nodes[random_node_2]);
+    int connection_innovation_nb = this->get_innovation_number(innovation_tracker, random_node_1, random_node_2);
 
     // Add the connection with a random weight
-    this->genes.push_back(
-        std::make_shared<ConnectionGene>(
-            this->nodes[random_node_1],
-            this->nodes[random_node_2],
-            new_connection_weight(),
-            connection_innovation_nb,
-            this->config.enabled_default));
-
-    this->connect_nodes();
+    this->genes.add(random_node_1, random_node_2, new_connection_weight(), connection_innovation_nb, this->config->enabled_default);
 }
 
 void neat::Genome::remove_connection()
 {
-    if (!this->genes.empty())
+    if (this->genes.size() > 0)
     {
-        auto random_gene = this->genes.begin() + randrange(0, this->genes.size());
-        this->genes.erase(random_gene);
+        this->genes.remove(randrange(0, this->genes.size()));
     }
 }
 
 double neat::Genome::new_connection_weight() const
 {
-    double weight = 0.0;
-
-    if (this->config.weight_init_type == "normal")
-    {
-        weight = normal(this->config.weight_init_mean, this->config.weight_init_stdev);
-
-        // Keep the value between bounds
-        if (weight > this->config.weight_max_value)
-        {
-            weight = this->config.weight_max_value;
-        }
-        if (weight < this->config.weight_min_value)
-        {
-            weight = this->config.weight_min_value;
-        }
-    }
-    else if (this->config.weight_init_type == "uniform")
-    {
-        weight = uniform(this->config.weight_min_value, this->config.weight_max_value);
-    }
-
+    double weight;
+    this->new_connection_weights(&weight, 1);
     return weight;
 }
 
-int neat::Genome::get_innovation_number(std::vector<std::shared_ptr<ConnectionHistory>> innovation_history, std::shared_ptr<Node> from_node, std::shared_ptr<Node> to_node) const
+void neat::Genome::new_connection_weights(double *weights, int n) const
 {
-    bool is_new = true;
-    int connection_innovation_nb = next_innovation_nb;
-
-    for (auto &history : innovation_history)
+    if (this->config->weight_init_type == DistributionType::NORMAL)
     {
-        // For each previous mutation
-        if (history->matches(from_node, to_node))
+        normal_n(weights, n, this->config->weight_init_mean, this->config->weight_init_stdev);
+
+        // Keep the values between bounds
+        for (int i = 0; i < n; ++i)
         {
-            // If a match is found
-            is_new = false; // It's not a new mutation
-            connection_innovation_nb = history->innovation_nb;
-            break;
+            weights[i] = std::min(std::max(weights[i], this->config->weight_min_value), this->config->weight_max_value);
         }
     }
-
-    if (is_new)
+    else if (this->config->weight_init_type == DistributionType::UNIFORM)
     {
-        // Add this mutation to the innovation history
-        innovation_history.push_back(std::make_shared<ConnectionHistory>(from_node, to_node, connection_innovation_nb));
-        ++next_innovation_nb;
+        for (int i = 0; i < n; ++i)
+        {
+            weights[i] = uniform(this->config->weight_min_value, this->config->weight_max_value);
+        }
     }
+}
 
-    return connection_innovation_nb;
+int neat::Genome::get_innovation_number(InnovationTracker &innovation_tracker, int from_node, int to_node) const
+{
+    return innovation_tracker.get_innovation_number(this->nodes.ids[from_node], this->nodes.ids[to_node]);
 }
 
 bool neat::Genome::fully_connected() const
 {
     int max_connections = 0;
 
-    // Array that stores the number of nodes in each layer
-    std::vector<int> nodes_in_layers(layers, 0);
+    // Array that stores the number of nodes in each layer, reused by the calls of the thread
+    static thread_local std::vector<int> nodes_in_layers;
+    nodes_in_layers.assign(this->layers, 0);
 
-    // Populate the array
-    for (const auto &node : this->nodes)
+    // Populate the array, skipping the nodes left outside the layers, which aren't part of the network either
+    for (int layer : this->nodes.layers)
     {
-        ++nodes_in_layers[node->layer];
+        if (layer >= 0 && layer < this->layers)
+        {
+            ++nodes_in_layers[layer];
+        }
     }
 
     // For each layer, calculate the maximum number of connections
@@ -478,44 +514,37 @@ bool neat::Genome::fully_connected() const
         max_connections += nodes_in_layers[i] * nodes_in_front;
     }
 
-    return max_connections <= static_cast<int>(this->genes.size());
+    return max_connections <= this->genes.size();
 }
 
-void neat::Genome::mutate(std::vector<std::shared_ptr<ConnectionHistory>> innovation_history)
+void neat::Genome::mutate(InnovationTracker &innovation_tracker)
 {
     try
     {
-        if (this->genes.empty())
-        {
-            this->add_connection(innovation_history);
-        }
-
-        for (auto &node : this->nodes)
+        if (this->genes.size() == 0)
         {
-            node->mutate(this->config);
+            this->add_connection(innovation_tracker);
         }
 
-        for (auto &gene : this->genes)
-        {
-            gene->mutate(this->config);
-        }
+        this->nodes.mutate(*this->config);
+        this->genes.mutate(*this->config);
 
-        if (randrange() < this->config.conn_add_prob)
+        if (randrange() < this->config->conn_add_prob)
         {
-            this->add_connection(innovation_history);
+            this->add_connection(innovation_tracker);
         }
 
-        if (randrange() < this->config.conn_delete_prob)
+        if (randrange() < this->config->conn_delete_prob)
         {
             this->remove_connection();
         }
 
-        if (randrange() < this->config.node_add_prob)
+        if (randrange() < this->config->node_add_prob)
         {
-            this->add_node(innovation_history);
+            this->add_node(innovation_tracker);
         }
 
-        if (randrange() < this->config.node_delete_prob)
+        if (randrange() < this->config->node_delete_prob)
         {
             this->remove_node();
         }
@@ -526,29 +555,41 @@ void neat::Genome::mutate(std::vector<std::shared_ptr<ConnectionHistory>> innova
     }
 }
 
-neat::Genome *neat::Genome::crossover(Genome *parent) const
+neat::Genome *neat::Genome::crossover(Genome *parent, GenomeArena *arena) const
 {
-    Genome *child = new Genome(this->config, true);
-    child->genes.clear();
-    child->nodes.clear();
+    Genome *child = arena != nullptr ? arena->recycle(this->config) : new Genome(this->config, true);
     child->inputs = this->inputs;
     child->outputs = this->outputs;
     child->layers = this->layers;
     child->next_node = this->next_node;
 
-    std::vector<std::shared_ptr<ConnectionGene>> child_genes;
-    std::vector<bool> is_enabled;
+    // Since all excess and disjoint genes are inherited from the more fit parent (this Genome),
+    // the child structure is no different from this parent, except for dormant connections being enabled,
+    // but this won't affect nodes.
+    // So, all the nodes can be inherited from this parent.
+    child->nodes = this->nodes;
+    child->genes.reserve(this->genes.size());
+
+    // Both gene arrays are sorted by innovation number, so the matching genes are found in a single merge pass.
+    // A repeated innovation number of this parent matches the first gene of the other parent with that number.
+    const std::vector<int> &parent_innovation_nbs = parent->genes.innovation_nbs;
+    int parent_gene_index = 0;
 
-    // All inherited genes
-    for (const auto &gene : this->genes)
+    // All inherited genes, in innovation order so that they are appended to the child
+    for (int i = 0; i < this->genes.size(); ++i)
     {
         bool set_enabled = true; // Is this connection in the child going to be enabled
 
-        int parent_gene_index = matching_gene(parent, gene->innovation_nb);
-        if (parent_gene_index != -1)
+        int innovation_nb = this->genes.innovation_nbs[i];
+        while (parent_gene_index < parent->genes.size() && parent_innovation_nbs[parent_gene_index] < innovation_nb)
+        {
+            ++parent_gene_index;
+        }
+
+        if (parent_gene_index < parent->genes.size() && parent_innovation_nbs[parent_gene_index] == innovation_nb)
         {
             // If the genes match
-            if (!gene->enabled || !parent->genes[parent_gene_index]->enabled)
+            if (!this->genes.enabled[i] || !parent->genes.enabled[parent_gene_index])
             {
                 // If either of the matching genes is disabled
                 if (randrange() < 0.75)
@@ -560,54 +601,37 @@ neat::Genome *neat::Genome::crossover(Genome *parent) const
 
             if (randrange() < 0.5)
             {
-                child_genes.push_back(gene);
+                child->genes.add(this->genes.from_nodes[i], this->genes.to_nodes[i], this->genes.weights[i], innovation_nb, set_enabled);
             }
             else
             {
-                // Get gene from the parent
-                child_genes.push_back(parent->genes[parent_gene_index]);
+                // Get gene from the parent, connected to the child nodes with the same IDs
+                child->genes.add(
+                    child->get_node(parent->nodes.ids[parent->genes.from_nodes[parent_gene_index]]),
+                    child->get_node(parent->nodes.ids[parent->genes.to_nodes[parent_gene_index]]),
+                    parent->genes.weights[parent_gene_index],
+                    innovation_nb,
+                    set_enabled);
             }
         }
         else
         {
             // Disjoint or excess gene
-            child_genes.push_back(gene);
-            set_enabled = gene->enabled;
+            child->genes.add(this->genes.from_nodes[i], this->genes.to_nodes[i], this->genes.weights[i], innovation_nb, this->genes.enabled[i]);
         }
-
-        is_enabled.push_back(set_enabled);
-    }
-
-    // Since all excess and disjoint genes are inherited from the more fit parent (this Genome),
-    // the child structure is no different from this parent, except for dormant connections being enabled,
-    // but this won't affect nodes.
-    // So, all the nodes can be inherited from this parent.
-    for (auto &node : this->nodes)
-    {
-        child->nodes.push_back(node->clone());
-    }
-
-    // Clone all the connections so that they connect the child new nodes
-    for (size_t i = 0; i < child_genes.size(); ++i)
-    {
-        child->genes.push_back(child_genes[i]->clone(
-            child->get_node(child_genes[i]->from_node->id),
-            child->get_node(child_genes[i]->to_node->id)));
-        child->genes[i]->enabled = is_enabled[i];
     }
 
-    child->connect_nodes();
     return child;
 }
 
 int neat::Genome::matching_gene(Genome *parent, int innovation) const
 {
-    for (size_t i = 0; i < parent->genes.size(); ++i)
+    // The genes are sorted by innovation number
+    const std::vector<int> &innovation_nbs = parent->genes.innovation_nbs;
+    auto it = std::lower_bound(innovation_nbs.begin(), innovation_nbs.end(), innovation);
+    if (it != innovation_nbs.end() && *it == innovation)
     {
-        if (parent->genes[i]->innovation_nb == innovation)
-        {
-            return i;
-        }
+        return it - innovation_nbs.begin();
     }
     return -1; // No matching gene found
 }
@@ -621,16 +645,18 @@ void neat::Genome::print() const
               << "}\n";
     std::cout << "⚪️ Connection genes:\n";
 
-    for (const auto &gene : this->genes)
+    for (int i = 0; i < this->genes.size(); ++i)
     {
+        int from_node = this->genes.from_nodes[i];
+        int to_node = this->genes.to_nodes[i];
         std::cout << "{"
-                  << "innovation_nb: " << gene->innovation_nb << ", "
-                  << "from_node: " << gene->from_node->id << ", "
-                  << "to_node: " << gene->to_node->id << ", "
-                  << "enabled: " << gene->enabled << ", "
-                  << "from_layer: " << gene->from_node->layer << ", "
-                  << "to_layer: " << gene->to_node->layer << ", "
-                  << "weight: " << gene->weight << "}\n";
+                  << "innovation_nb: " << this->genes.innovation_nbs[i] << ", "
+                  << "from_node: " << this->nodes.ids[from_node] << ", "
+                  << "to_node: " << this->nodes.ids[to_node] << ", "
+                  << "enabled: " << this->genes.enabled[i] << ", "
+                  << "from_layer: " << this->nodes.layers[from_node] << ", "
+                  << "to_layer: " << this->nodes.layers[to_node] << ", "
+                  << "weight: " << this->genes.weights[i] << "}\n";
     }
 
     std::cout << std::endl;
@@ -651,12 +677,14 @@ bool neat::Genome::is_equal(Genome *other)
     }
 
     // Compare the nodes
-    for (auto &node1 : this->nodes)
+    for (int i = 0; i < this->nodes.size(); ++i)
     {
         bool found = false;
-        for (auto &node2 : other->nodes)
+        for (int j = 0; j < other->nodes.size(); ++j)
         {
-            if (node1->is_equal(node2))
+            if (this->nodes.ids[i] == other->nodes.ids[j] &&
+                this->nodes.activation_functions[i] == other->nodes.activation_functions[j] &&
+                this->nodes.layers[i] == other->nodes.layers[j])
             {
                 found = true;
                 break;
@@ -669,12 +697,16 @@ bool neat::Genome::is_equal(Genome *other)
     }
 
     // Compare the genes
-    for (auto &gene1 : this->genes)
+    for (int i = 0; i < this->genes.size(); ++i)
     {
         bool found = false;
-        for (auto &gene2 : other->genes)
+        for (int j = 0; j < other->genes.size(); ++j)
         {
-            if (gene1->is_equal(gene2))
+            if (this->nodes.ids[this->genes.from_nodes[i]] == other->nodes.ids[other->genes.from_nodes[j]] &&
+                this->nodes.ids[this->genes.to_nodes[i]] == other->nodes.ids[other->genes.to_nodes[j]] &&
+                this->genes.weights[i] == other->genes.weights[j] &&
+                this->genes.innovation_nbs[i] == other->genes.innovation_nbs[j] &&
+                this->genes.enabled[i] == other->genes.enabled[j])
             {
                 found = true;
                 break;
@@ -689,30 +721,20 @@ bool neat::Genome::is_equal(Genome *other)
     return true;
 }
 
-neat::Genome *neat::Genome::clone()
+neat::Genome *neat::Genome::clone(GenomeArena *arena)
 {
-    Genome *clone = new Genome(this->config, true);
-
-    // Copy nodes
-    for (auto &node : this->nodes)
-    {
-        clone->nodes.push_back(node->clone());
-    }
+    Genome *clone = arena != nullptr ? arena->recycle(this->config) : new Genome(this->config, true);
 
-    // Copy genes and connect them to the clone new nodes
-    for (auto &gene : this->genes)
-    {
-        clone->genes.push_back(gene->clone(
-            clone->get_node(gene->from_node->id),
-            clone->get_node(gene->to_node->id)));
-    }
+    // The genes refer to the nodes by index, so both arrays can be copied as they are
+    clone->nodes = this->nodes;
+    clone->genes = this->genes;
+    clone->network = this->network;
 
     clone->inputs = this->inputs;
     clone->outputs = this->outputs;
     clone->layers = this->layers;
     clone->next_node = this->next_node;
     clone->fitness = this->fitness;
-    clone->connect_nodes();
 
     return clone;
 }
@@ -731,28 +753,28 @@ nlohmann::json neat::Genome::to_json() const
     genome_json["fitness"] = this->fitness;
 
     nlohmann::json nodes_json;
-    for (const auto &node : this->nodes)
+    for (int i = 0; i < this->nodes.size(); ++i)
     {
         nlohmann::json node_json;
         // Serialize node data
-        node_json["id"] = node->id;
-        node_json["layer"] = node->layer;
-        node_json["activation_function"] = node->activation_function;
+        node_json["id"] = this->nodes.ids[i];
+        node_json["layer"] = this->nodes.layers[i];
+        node_json["activation_function"] = activation_function_to_string(this->nodes.activation_functions[i]);
         // Add node to nodes array
         nodes_json.push_back(node_json);
     }
     genome_json["nodes"] = nodes_json;
 
     nlohmann::json genes_json;
-    for (const auto &gene : this->genes)
+    for (int i = 0; i < this->genes.size(); ++i)
     {
         nlohmann::json gene_json;
         // Serialize gene data
-        gene_json["innovation_nb"] = gene->innovation_nb;
-        gene_json["from_node_id"] = gene->from_node->id;
-        gene_json["to_node_id"] = gene->to_node->id;
-        gene_json["enabled"] = gene->enabled;
-        gene_json["weight"] = gene->weight;
+        gene_json["innovation_nb"] = this->genes.innovation_nbs[i];
+        gene_json["from_node_id"] = this->nodes.ids[this->genes.from_nodes[i]];
+        gene_json["to_node_id"] = this->nodes.ids[this->genes.to_nodes[i]];
+        gene_json["enabled"] = static_cast<bool>(this->genes.enabled[i]);
+        gene_json["weight"] = this->genes.weights[i];
         // Add gene to genes array
         genes_json.push_back(gene_json);
     }
@@ -761,9 +783,14 @@ nlohmann::json neat::Genome::to_json() const
     return genome_json;
 }
 
-neat::Genome *neat::Genome::from_json(const nlohmann::json &json)
+neat::Genome *neat::Genome::from_json(const nlohmann::json &json, std::shared_ptr<const Config> config, GenomeArena *arena)
 {
-    neat::Genome *genome = new neat::Genome();
+    // A genome allocated here is deleted if the JSON turns out to be invalid
+    std::unique_ptr<neat::Genome> owned(arena != nullptr ? nullptr : new neat::Genome());
+    neat::Genome *genome = arena != nullptr ? arena->create() : owned.get();
+
+    // The file doesn't hold the configuration, which mutations, crossovers and clones need
+    genome->config = config != nullptr ? std::move(config) : std::make_shared<const Config>();
     genome->id = json["id"];
     genome->inputs = json["inputs"];
     genome->outputs = json["outputs"];
@@ -775,8 +802,14 @@ neat::Genome *neat::Genome::from_json(const nlohmann::json &json)
     {
         int id = node_json["id"];
         int layer = node_json["layer"];
-        std::string activation_function = node_json["activation_function"];
-        genome->nodes.push_back(std::make_shared<neat::Node>(id, activation_function, layer));
+
+        // The ids of a genome come from its counter of nodes
+        if (id >= genome->next_node)
+        {
+            throw std::invalid_argument("A node id isn't below the next node id of the genome.");
+        }
+        neat::ActivationFunction activation_function = neat::activation_function_from_string(node_json["activation_function"]);
+        genome->nodes.add(id, activation_function, layer);
     }
 
     for (const auto &gene_json : json["genes"])
@@ -787,13 +820,18 @@ neat::Genome *neat::Genome::from_json(const nlohmann::json &json)
         bool enabled = gene_json["enabled"];
         double weight = gene_json["weight"];
 
-        std::shared_ptr<neat::Node> from_node = genome->get_node(from_node_id);
-        std::shared_ptr<neat::Node> to_node = genome->get_node(to_node_id);
+        int from_node = genome->get_node(from_node_id);
+        int to_node = genome->get_node(to_node_id);
+        if (from_node == -1 || to_node == -1)
+        {
+            throw std::invalid_argument("A connection gene refers to an unknown node.");
+        }
 
-        genome->genes.push_back(std::make_shared<neat::ConnectionGene>(from_node, to_node, weight, innovation_nb, enabled));
+        genome->genes.add(from_node, to_node, weight, innovation_nb, enabled);
     }
 
     genome->generate_network();
+    owned.release();
     return genome;
 }
 
@@ -834,7 +872,7 @@ void neat::Genome::save(const std::string &file_path)
     }
 }
 
-neat::Genome *neat::Genome::load(const std::string &file_path)
+neat::Genome *neat::Genome::load(const std::string &file_path, std::shared_ptr<const Config> config)
 {
     try
     {
@@ -844,7 +882,7 @@ neat::Genome *neat::Genome::load(const std::string &file_path)
         file >> genome_json;
 
         // Create a new Genome object
-        Genome *loadedGenome = Genome::from_json(genome_json);
+        Genome *loadedGenome = Genome::from_json(genome_json, std::move(config));
 
         std::cout << "Genome loaded from '" << file_path << "'" << std::endl;
         loadedGenome->generate_network();
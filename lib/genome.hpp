@@ -4,58 +4,82 @@
 #include <iostream>
 #include <vector>
 #include <string>
+#include <memory>
+#include <cstdint>
 #include "json.hpp"
 #include "config.hpp"
+#include "node.hpp"
 #include "connection_gene.hpp"
+#include "compiled_network.hpp"
 
 namespace neat
 {
 
-    class ConnectionHistory; // Forward declaration
-    class Node;              // Forward declaration
+    class InnovationTracker; // Forward declaration
+    class GenomeArena;       // Forward declaration
 
     /**
      * @brief Represents a genome in the NEAT (NeuroEvolution of Augmenting Topologies) algorithm.
+     *
+     * The nodes and connection genes are stored in contiguous arrays, and the genes refer to their nodes by index.
      */
     class Genome
     {
     public:
-        std::string id;                                     // Unique identifier for the genome.
-        Config config;                                      // Configuration settings for NEAT.
-        std::vector<std::shared_ptr<ConnectionGene>> genes; // List of connection genes.
-        std::vector<std::shared_ptr<Node>> nodes;           // List of nodes in the genome.
-        int inputs;                                         // Number of input nodes.
-        int outputs;                                        // Number of output nodes.
-        int layers;                                         // Number of layers in the neural network.
-        int next_node;                                      // ID for the next node to be added.
-        std::vector<std::shared_ptr<Node>> network;         // Fully connected network.
-        double fitness;                                     // Fitness score of the genome.
+        std::string id;                       // Unique identifier for the genome.
+        std::shared_ptr<const Config> config; // Configuration settings for NEAT, shared by the genomes of a population.
+        ConnectionGenes genes;                // Connection genes of the genome.
+        NodeGenes nodes;                      // Nodes of the genome.
+        int inputs;                           // Number of input nodes.
+        int outputs;                          // Number of output nodes.
+        int layers;                           // Number of layers in the neural network.
+        int next_node;                        // ID for the next node to be added.
+        CompiledNetwork network;              // Network built from the genes by generate_network.
+        double fitness;                       // Fitness score of the genome.
 
         Genome();
+
+        /**
+         * @brief Constructor for the Genome class, with its own copy of the configuration.
+         * @param config Configuration settings for NEAT.
+         * @param crossover If true, the genome is left empty to be filled by a crossover or a clone.
+         */
         Genome(const Config &config, bool crossover = false);
 
         /**
-         * @brief Destructor for the Genome class.
+         * @brief Constructor for the Genome class, sharing the configuration of a population.
+         * @param config Configuration settings for NEAT.
+         * @param crossover If true, the genome is left empty to be filled by a crossover or a clone.
+         */
+        Genome(std::shared_ptr<const Config> config, bool crossover = false);
+
+        /**
+         * @brief Empties the genome in place, as if it had just been constructed for a crossover,
+         * keeping the storage of its nodes, genes and network for the next genome built in it.
+         * @param config Configuration of the genome.
          */
-        ~Genome();
+        void reset(const std::shared_ptr<const Config> &config);
 
         /**
          * @brief Fully connects the genome's neural network.
-         * @param innovation_history List of connection history for innovation tracking.
+         * @param innovation_tracker Innovations of the population.
          */
-        void fully_connect(std::vector<std::shared_ptr<ConnectionHistory>> innovation_history);
+        void fully_connect(InnovationTracker &innovation_tracker);
 
         /**
-         * @brief Retrieves a node based on its ID.
+         * @brief Retrieves the index of a node based on its ID.
          * @param id ID of the node.
-         * @return Pointer to the node if found, nullptr otherwise.
+         * @return Index of the node if found, -1 otherwise.
          */
-        std::shared_ptr<Node> get_node(int id);
+        int get_node(int id) const;
 
         /**
-         * @brief Connects nodes based on the genome's genes.
+         * @brief Checks if two nodes of different layers are connected by a gene.
+         * @param node1 Index of the first node.
+         * @param node2 Index of the second node.
+         * @return True if a gene goes from the node of the lowest layer to the other one, false otherwise.
          */
-        void connect_nodes();
+        bool is_connected(int node1, int node2) const;
 
         /**
          * @brief Performs a feed-forward operation on the neural network.
@@ -65,15 +89,21 @@ namespace neat
         std::vector<double> feed_forward(std::vector<double> input_values);
 
         /**
-         * @brief Generates the network structure by adding nodes and connections.
+         * @brief Compiles the network from the current nodes and genes, to be called after the genome has changed.
          */
         void generate_network();
 
+        /**
+         * @brief Hashes the structure and the weights of the genome, so that identical genomes get the same value.
+         * @return 64-bit hash of the nodes and connection genes.
+         */
+        std::uint64_t hash() const;
+
         /**
          * @brief Adds a node to the genome.
-         * @param innovation_history List of connection history for innovation tracking.
+         * @param innovation_tracker Innovations of the population.
          */
-        void add_node(std::vector<std::shared_ptr<ConnectionHistory>> innovation_history);
+        void add_node(InnovationTracker &innovation_tracker);
 
         /**
          * @brief Removes a node from the genome.
@@ -82,9 +112,9 @@ namespace neat
 
         /**
          * @brief Adds a connection to the genome.
-         * @param innovation_history List of connection history for innovation tracking.
+         * @param innovation_tracker Innovations of the population.
          */
-        void add_connection(std::vector<std::shared_ptr<ConnectionHistory>> innovation_history);
+        void add_connection(InnovationTracker &innovation_tracker);
 
         /**
          * @brief Removes a connection from the genome.
@@ -97,14 +127,21 @@ namespace neat
          */
         double new_connection_weight() const;
 
+        /**
+         * @brief Generates many new random connection weights at once, based on configuration settings.
+         * @param weights Buffer of n weights to fill.
+         * @param n Number of weights.
+         */
+        void new_connection_weights(double *weights, int n) const;
+
         /**
          * @brief Gets the innovation number for a connection between two nodes.
-         * @param innovation_history List of connection history for innovation tracking.
-         * @param from_node Pointer to the source node.
-         * @param to_node Pointer to the target node.
+         * @param innovation_tracker Innovations of the population.
+         * @param from_node Index of the source node.
+         * @param to_node Index of the target node.
          * @return Innovation number for the connection.
          */
-        int get_innovation_number(std::vector<std::shared_ptr<ConnectionHistory>> innovation_history, std::shared_ptr<Node> from_node, std::shared_ptr<Node> to_node) const;
+        int get_innovation_number(InnovationTracker &innovation_tracker, int from_node, int to_node) const;
 
         /**
          * @brief Checks if the genome is fully connected.
@@ -114,16 +151,17 @@ namespace neat
 
         /**
          * @brief Mutates the genome based on configuration settings.
-         * @param innovation_history List of connection history for innovation tracking.
+         * @param innovation_tracker Innovations of the population.
          */
-        void mutate(std::vector<std::shared_ptr<ConnectionHistory>> innovation_history);
+        void mutate(InnovationTracker &innovation_tracker);
 
         /**
          * @brief Performs crossover with another genome to create a child genome.
          * @param parent Parent genome for crossover.
+         * @param arena Arena in which the child is created, nullptr to allocate it with new.
          * @return Child genome resulting from crossover.
          */
-        Genome *crossover(Genome *parent) const;
+        Genome *crossover(Genome *parent, GenomeArena *arena = nullptr) const;
 
         /**
          * @brief Finds the index of a matching gene in another genome.
@@ -147,9 +185,10 @@ namespace neat
 
         /**
          * @brief Creates a clone of the genome.
+         * @param arena Arena in which the clone is created, nullptr to allocate it with new.
          * @return Cloned genome.
          */
-        Genome *clone();
+        Genome *clone(GenomeArena *arena = nullptr);
 
         /**
          * @brief Converts the genome to a JSON object.
@@ -160,9 +199,11 @@ namespace neat
         /**
          * @brief Creates a genome from a JSON object.
          * @param json JSON object representing the genome.
+         * @param config Configuration of the genome, nullptr for the default configuration.
+         * @param arena Arena in which the genome is created, nullptr to allocate it with new.
          * @return Genome created from the JSON object.
          */
-        static Genome *from_json(const nlohmann::json &json);
+        static Genome *from_json(const nlohmann::json &json, std::shared_ptr<const Config> config = nullptr, GenomeArena *arena = nullptr);
 
         /**
          * @brief Saves the genome to a binary file.
@@ -173,9 +214,10 @@ namespace neat
         /**
          * @brief Loads a genome from a binary file.
          * @param file_path Path to the file.
+         * @param config Configuration of the genome, nullptr for the default configuration.
          * @return Loaded genome.
          */
-        static Genome *load(const std::string &file_path);
+        static Genome *load(const std::string &file_path, std::shared_ptr<const Config> config = nullptr);
     };
 }
 
@@ -0,0 +1,108 @@
+#include <new>
+#include "genome.hpp"
+#include "genome_arena.hpp"
+
+neat::GenomeArena::GenomeArena(int block_size) : block_size(block_size > 0 ? block_size : 1), count(0), constructed(0) {}
+
+neat::GenomeArena::~GenomeArena()
+{
+    for (size_t i = 0; i < this->alive.size(); ++i)
+    {
+        if (this->alive[i])
+        {
+            this->blocks[i / this->block_size][i % this->block_size].~Genome();
+        }
+    }
+    for (auto block : this->blocks)
+    {
+        ::operator delete(block);
+    }
+}
+
+neat::Genome *neat::GenomeArena::recycle(const std::shared_ptr<const Config> &config)
+{
+    bool released;
+    int index;
+    Genome *slot = this->allocate(released, index);
+    try
+    {
+        if (released)
+        {
+            slot->reset(config);
+        }
+        else
+        {
+            new (slot) Genome(config, true);
+            this->commit(index);
+        }
+    }
+    catch (...)
+    {
+        this->cancel(index);
+        throw;
+    }
+    return slot;
+}
+
+void neat::GenomeArena::reset()
+{
+    std::lock_guard<std::mutex> lock(this->mutex);
+    this->count = 0;
+}
+
+void neat::GenomeArena::reserve(int capacity)
+{
+    std::lock_guard<std::mutex> lock(this->mutex);
+    while (static_cast<int>(this->blocks.size()) * this->block_size < capacity)
+    {
+        this->add_block();
+    }
+}
+
+int neat::GenomeArena::size() const
+{
+    return this->count;
+}
+
+int neat::GenomeArena::capacity() const
+{
+    return this->constructed;
+}
+
+neat::Genome *neat::GenomeArena::allocate(bool &released, int &index)
+{
+    std::lock_guard<std::mutex> lock(this->mutex);
+    if (this->count == static_cast<int>(this->blocks.size()) * this->block_size)
+    {
+        this->add_block();
+    }
+
+    index = this->count++;
+    released = this->alive[index];
+    return &this->blocks[index / this->block_size][index % this->block_size];
+}
+
+void neat::GenomeArena::add_block()
+{
+    // Everything that can fail is done before the block is taken, so a failed allocation leaves the arena unchanged
+    this->alive.resize((this->blocks.size() + 1) * this->block_size, false);
+    this->blocks.reserve(this->blocks.size() + 1);
+    this->blocks.push_back(static_cast<Genome *>(::operator new(sizeof(Genome) * this->block_size)));
+}
+
+void neat::GenomeArena::commit(int index)
+{
+    std::lock_guard<std::mutex> lock(this->mutex);
+    this->alive[index] = true;
+    ++this->constructed;
+}
+
+void neat::GenomeArena::cancel(int index)
+{
+    // The slot can only be taken back if no other genome was handed out after it, otherwise it stays unused until the next reset
+    std::lock_guard<std::mutex> lock(this->mutex);
+    if (index == this->count - 1)
+    {
+        --this->count;
+    }
+}
@@ -0,0 +1,135 @@
+#ifndef NEAT_GENOME_ARENA_HPP
+#define NEAT_GENOME_ARENA_HPP
+
+#include <mutex>
+#include <vector>
+#include <utility>
+#include "genome.hpp"
+
+namespace neat
+{
+
+    /**
+     * @brief Region allocator and pool holding the genomes of a generation.
+     *
+     * The genomes are constructed one after the other in large blocks, and all of them are released at once by reset.
+     * The released genomes stay alive in the arena and are handed out again by recycle with the storage of their nodes,
+     * genes and network, so building a generation of the same size as the previous one barely allocates.
+     * A genome created by an arena must never be deleted.
+     */
+    class GenomeArena
+    {
+    public:
+        /**
+         * @brief Constructor for the GenomeArena class.
+         * @param block_size Number of genomes per block.
+         */
+        GenomeArena(int block_size = 256);
+
+        /**
+         * @brief Destructor for the GenomeArena class, destroys the genomes and frees the blocks.
+         */
+        ~GenomeArena();
+
+        GenomeArena(const GenomeArena &) = delete;
+        GenomeArena &operator=(const GenomeArena &) = delete;
+
+        /**
+         * @brief Constructs a genome in the arena.
+         * @param args Arguments forwarded to the constructor of the genome.
+         * @return Genome owned by the arena, valid until the next reset.
+         */
+        template <typename... Args>
+        Genome *create(Args &&...args)
+        {
+            bool released;
+            int index;
+            Genome *slot = this->allocate(released, index);
+            try
+            {
+                if (released)
+                {
+                    // Replaced in one step, so a throwing constructor leaves the released genome in place
+                    *slot = Genome(std::forward<Args>(args)...);
+                }
+                else
+                {
+                    new (slot) Genome(std::forward<Args>(args)...);
+                    this->commit(index);
+                }
+            }
+            catch (...)
+            {
+                this->cancel(index);
+                throw;
+            }
+            return slot;
+        }
+
+        /**
+         * @brief Takes an empty genome, as constructed for a crossover, reusing a released genome when there is one.
+         * @param config Configuration of the genome.
+         * @return Genome owned by the arena, valid until the next reset.
+         */
+        Genome *recycle(const std::shared_ptr<const Config> &config);
+
+        /**
+         * @brief Releases all the genomes of the arena, keeping them and their storage to build the next generation.
+         */
+        void reset();
+
+        /**
+         * @brief Allocates the blocks needed to hold a number of genomes.
+         * @param capacity Number of genomes.
+         */
+        void reserve(int capacity);
+
+        /**
+         * @brief Returns the number of genomes handed out since the last reset.
+         * @return Number of genomes.
+         */
+        int size() const;
+
+        /**
+         * @brief Returns the number of genomes alive in the arena, handed out or released.
+         * @return Number of genomes.
+         */
+        int capacity() const;
+
+    private:
+        std::vector<Genome *> blocks; // Raw storage for block_size genomes each.
+        int block_size;               // Number of genomes per block.
+        int count;                    // Number of genomes handed out since the last reset.
+        int constructed;              // Number of genomes alive in the blocks, handed out or released.
+        std::vector<bool> alive;      // Whether each slot of the blocks holds a constructed genome.
+        std::mutex mutex;             // Lets several threads create genomes at once.
+
+        /**
+         * @brief Takes the slot of the next genome, adding a block if they are all full.
+         * @param released Set to true if the slot still holds a released genome, false if it must be constructed.
+         * @param index Set to the index of the slot.
+         * @return Storage for a genome.
+         */
+        Genome *allocate(bool &released, int &index);
+
+        /**
+         * @brief Adds a block of slots, to be called with the mutex locked.
+         */
+        void add_block();
+
+        /**
+         * @brief Records that a genome has been constructed in a slot, so that the arena destroys it.
+         * @param index Index of the slot.
+         */
+        void commit(int index);
+
+        /**
+         * @brief Gives back a slot whose genome couldn't be built.
+         * @param index Index of the slot.
+         */
+        void cancel(int index);
+    };
+
+}
+
+#endif
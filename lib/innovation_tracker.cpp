@@ -0,0 +1,81 @@
+#include "innovation_tracker.hpp"
+
+// Packs the node IDs of a connection into a single key
+static std::uint64_t connection_key(int from_node_id, int to_node_id)
+{
+    return static_cast<std::uint64_t>(static_cast<std::uint32_t>(from_node_id)) << 32 | static_cast<std::uint32_t>(to_node_id);
+}
+
+neat::InnovationTracker::InnovationTracker(int next_innovation_nb) : next_innovation_nb(next_innovation_nb) {}
+
+neat::InnovationTracker::InnovationTracker(const InnovationTracker &other)
+{
+    std::lock_guard<std::mutex> lock(other.mutex);
+    this->innovations = other.innovations;
+    this->keys = other.keys;
+    this->next_innovation_nb = other.next_innovation_nb;
+}
+
+neat::InnovationTracker &neat::InnovationTracker::operator=(const InnovationTracker &other)
+{
+    if (this != &other)
+    {
+        std::scoped_lock lock(this->mutex, other.mutex);
+        this->innovations = other.innovations;
+        this->keys = other.keys;
+        this->next_innovation_nb = other.next_innovation_nb;
+    }
+    return *this;
+}
+
+int neat::InnovationTracker::get_innovation_number(int from_node_id, int to_node_id)
+{
+    std::lock_guard<std::mutex> lock(this->mutex);
+    return this->record(connection_key(from_node_id, to_node_id));
+}
+
+std::vector<int> neat::InnovationTracker::resolve(const InnovationTracker &provisional_tracker, int first_innovation_nb)
+{
+    std::scoped_lock lock(this->mutex, provisional_tracker.mutex);
+
+    // The provisional numbers follow each other from first_innovation_nb, in the order of the keys
+    std::vector<int> innovation_nbs(provisional_tracker.next_innovation_nb - first_innovation_nb);
+    for (std::uint64_t key : provisional_tracker.keys)
+    {
+        innovation_nbs[provisional_tracker.innovations.at(key) - first_innovation_nb] = this->record(key);
+    }
+
+    return innovation_nbs;
+}
+
+void neat::InnovationTracker::reset()
+{
+    std::lock_guard<std::mutex> lock(this->mutex);
+    this->innovations.clear();
+    this->keys.clear();
+}
+
+int neat::InnovationTracker::get_next_innovation_nb() const
+{
+    std::lock_guard<std::mutex> lock(this->mutex);
+    return this->next_innovation_nb;
+}
+
+void neat::InnovationTracker::set_next_innovation_nb(int next_innovation_nb)
+{
+    std::lock_guard<std::mutex> lock(this->mutex);
+    this->next_innovation_nb = next_innovation_nb;
+}
+
+int neat::InnovationTracker::record(std::uint64_t key)
+{
+    // Give the connection the next innovation number if no genome has mutated in the same way
+    auto inserted = this->innovations.emplace(key, this->next_innovation_nb);
+    if (inserted.second)
+    {
+        this->keys.push_back(key);
+        ++this->next_innovation_nb;
+    }
+
+    return inserted.first->second;
+}
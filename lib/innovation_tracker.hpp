@@ -0,0 +1,83 @@
+#ifndef NEAT_INNOVATION_TRACKER_HPP
+#define NEAT_INNOVATION_TRACKER_HPP
+
+#include <cstdint>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace neat
+{
+
+    /**
+     * @brief Keeps track of the connection innovations of a population in the NEAT (NeuroEvolution of Augmenting Topologies) algorithm.
+     *
+     * The innovations are indexed by the IDs of the nodes they connect, so that the same structural mutation
+     * gets the same innovation number in every genome. The tracker can be shared by threads mutating genomes concurrently.
+     *
+     * To keep the numbers independent of the thread scheduling, each child of a generation can instead be mutated with
+     * its own provisional tracker, whose innovations are then resolved in the population's tracker in the order of the children.
+     */
+    class InnovationTracker
+    {
+    public:
+        /**
+         * @brief Constructor for InnovationTracker.
+         * @param next_innovation_nb Innovation number given to the next new connection.
+         */
+        InnovationTracker(int next_innovation_nb = 1);
+
+        InnovationTracker(const InnovationTracker &other);
+        InnovationTracker &operator=(const InnovationTracker &other);
+
+        /**
+         * @brief Gets the innovation number of a connection between two nodes, recording it if it is new.
+         * @param from_node_id ID of the source node.
+         * @param to_node_id ID of the target node.
+         * @return Innovation number of the connection.
+         */
+        int get_innovation_number(int from_node_id, int to_node_id);
+
+        /**
+         * @brief Forgets the recorded innovations, to be called at each generation.
+         * The innovation numbers keep increasing, so new connections never reuse a number.
+         */
+        void reset();
+
+        /**
+         * @brief Records the innovations of a provisional tracker, in the order in which it numbered them.
+         * @param provisional_tracker Tracker used to mutate a single genome, whose first innovation number is given by first_innovation_nb.
+         * @param first_innovation_nb First innovation number given by the provisional tracker.
+         * @return Innovation number in this tracker of each provisional number, from first_innovation_nb on.
+         */
+        std::vector<int> resolve(const InnovationTracker &provisional_tracker, int first_innovation_nb);
+
+        /**
+         * @brief Returns the innovation number given to the next new connection.
+         * @return Next innovation number.
+         */
+        int get_next_innovation_nb() const;
+
+        /**
+         * @brief Sets the innovation number given to the next new connection, e.g. when resuming a saved population.
+         * @param next_innovation_nb Next innovation number.
+         */
+        void set_next_innovation_nb(int next_innovation_nb);
+
+    private:
+        std::unordered_map<std::uint64_t, int> innovations; // Innovation number of each connection, keyed by its node IDs.
+        std::vector<std::uint64_t> keys;                     // Keys of the recorded connections, in the order they were numbered.
+        int next_innovation_nb;                              // Innovation number given to the next new connection.
+        mutable std::mutex mutex;                            // Protects the tracker from concurrent mutations.
+
+        /**
+         * @brief Gets the innovation number of a connection, recording it if it is new, with the mutex already locked.
+         * @param key Packed node IDs of the connection.
+         * @return Innovation number of the connection.
+         */
+        int record(std::uint64_t key);
+    };
+
+}
+
+#endif
@@ -2,14 +2,163 @@
 #include <cmath>
 #include <iostream>
 #include <random>
+#include <atomic>
+#include <algorithm>
 #include "math_utils.hpp"
 
+static std::uint64_t splitmix64(std::uint64_t &x)
+{
+    std::uint64_t z = (x += 0x9e3779b97f4a7c15);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111eb;
+    return z ^ (z >> 31);
+}
+
+static inline std::uint64_t rotl(std::uint64_t x, int k)
+{
+    return (x << k) | (x >> (64 - k));
+}
+
+neat::Xoshiro256::Xoshiro256(std::uint64_t seed)
+{
+    this->seed(seed);
+}
+
+void neat::Xoshiro256::seed(std::uint64_t seed)
+{
+    for (auto &s : this->state)
+    {
+        s = splitmix64(seed);
+    }
+}
+
+neat::Xoshiro256::result_type neat::Xoshiro256::operator()()
+{
+    const std::uint64_t result = rotl(this->state[1] * 5, 7) * 9;
+    const std::uint64_t t = this->state[1] << 17;
+
+    this->state[2] ^= this->state[0];
+    this->state[3] ^= this->state[1];
+    this->state[1] ^= this->state[2];
+    this->state[0] ^= this->state[3];
+    this->state[2] ^= t;
+    this->state[3] = rotl(this->state[3], 45);
+
+    return result;
+}
+
+neat::RandomStream::RandomStream(std::uint64_t seed, std::uint32_t generation, std::uint32_t index, RandomPurpose purpose)
+    : key{static_cast<std::uint32_t>(seed), static_cast<std::uint32_t>(seed >> 32)},
+      counter{0, static_cast<std::uint32_t>(purpose), index, generation},
+      block{0, 0, 0, 0},
+      position(2) {}
+
+neat::RandomStream::result_type neat::RandomStream::operator()()
+{
+    if (this->position == 2)
+    {
+        // Philox4x32 with 10 rounds
+        std::uint32_t c[4] = {this->counter[0], this->counter[1], this->counter[2], this->counter[3]};
+        std::uint32_t k[2] = {this->key[0], this->key[1]};
+        for (int round = 0; round < 10; ++round)
+        {
+            std::uint64_t p0 = static_cast<std::uint64_t>(0xD2511F53) * c[0];
+            std::uint64_t p1 = static_cast<std::uint64_t>(0xCD9E8D57) * c[2];
+            std::uint32_t next[4] = {
+                static_cast<std::uint32_t>(p1 >> 32) ^ c[1] ^ k[0],
+                static_cast<std::uint32_t>(p1),
+                static_cast<std::uint32_t>(p0 >> 32) ^ c[3] ^ k[1],
+                static_cast<std::uint32_t>(p0)};
+            std::copy(next, next + 4, c);
+            k[0] += 0x9E3779B9;
+            k[1] += 0xBB67AE85;
+        }
+        std::copy(c, c + 4, this->block);
+
+        ++this->counter[0];
+        this->position = 0;
+    }
+
+    std::uint64_t result = (static_cast<std::uint64_t>(this->block[2 * this->position]) << 32) | this->block[2 * this->position + 1];
+    ++this->position;
+    return result;
+}
+
+// Global seed, drawn from the system entropy source unless set with neat::seed
+static std::uint64_t entropy_seed()
+{
+    static std::uint64_t seed = (static_cast<std::uint64_t>(std::random_device{}()) << 32) | std::random_device{}();
+    return seed;
+}
+
+static std::atomic<std::uint64_t> seed_override{0};
+static std::atomic<unsigned> seed_epoch{0};  // Incremented on each call to neat::seed
+static std::atomic<unsigned> next_thread_index{0};
+
+namespace
+{
+    struct ThreadEngine
+    {
+        neat::Xoshiro256 engine;
+        unsigned epoch = ~0u;
+        unsigned thread_index = next_thread_index++;
+        neat::RandomStream *stream = nullptr; // Active scoped stream, if any
+    };
+}
+
+static thread_local ThreadEngine thread_engine;
+
+neat::ScopedRandomStream::ScopedRandomStream(std::uint64_t seed, std::uint32_t generation, std::uint32_t index, RandomPurpose purpose)
+    : stream(seed, generation, index, purpose), previous(thread_engine.stream)
+{
+    thread_engine.stream = &this->stream;
+}
+
+neat::ScopedRandomStream::~ScopedRandomStream()
+{
+    thread_engine.stream = this->previous;
+}
+
+void neat::seed(std::uint64_t seed)
+{
+    seed_override = seed;
+    ++seed_epoch;
+}
+
+void neat::seed_thread(std::uint64_t seed)
+{
+    thread_engine.engine.seed(seed);
+    thread_engine.epoch = seed_epoch;
+}
+
+std::uint64_t neat::get_seed()
+{
+    return seed_epoch == 0 ? entropy_seed() : seed_override.load();
+}
+
+std::uint64_t neat::random_bits()
+{
+    if (thread_engine.stream != nullptr)
+    {
+        return (*thread_engine.stream)();
+    }
+
+    unsigned epoch = seed_epoch;
+    if (thread_engine.epoch != epoch)
+    {
+        // (Re)seed from the global seed, each thread getting a different stream
+        std::uint64_t mix = get_seed() ^ (static_cast<std::uint64_t>(thread_engine.thread_index) << 32);
+        thread_engine.engine.seed(splitmix64(mix));
+        thread_engine.epoch = epoch;
+    }
+    return thread_engine.engine();
+}
+
 double neat::randrange(double min, double max)
 {
-    std::random_device rd;
-    std::mt19937 gen(rd());
-    std::uniform_real_distribution<double> distribution(min, max);
-    return distribution(gen);
+    // The 53 high bits give a double uniformly distributed in [0, 1)
+    double u = (random_bits() >> 11) * 0x1.0p-53;
+    return min + (max - min) * u;
 }
 
 double neat::uniform(double min, double max)
@@ -19,8 +168,43 @@ double neat::uniform(double min, double max)
 
 double neat::normal(double mean, double stdev)
 {
-    double u1 = randrange();
+    double u1 = 1.0 - randrange(); // (0, 1], to avoid log(0)
     double u2 = randrange();
     double z = sqrt(-2.0 * log(u1)) * cos(2.0 * M_PI * u2);
     return mean + stdev * z;
 }
+
+void neat::normal_n(double *values, int n, double mean, double stdev)
+{
+    // Draw all the uniform values first, so that the transform below is a loop without any call to the engine
+    for (int i = 0; i < n; ++i)
+    {
+        values[i] = randrange();
+    }
+    double last_u2 = n % 2 == 1 ? randrange() : 0.0;
+
+    for (int i = 0; i + 1 < n; i += 2)
+    {
+        double r = sqrt(-2.0 * log(1.0 - values[i])); // 1 - u1 is in (0, 1], to avoid log(0)
+        double theta = 2.0 * M_PI * values[i + 1];
+        values[i] = mean + stdev * r * cos(theta);
+        values[i + 1] = mean + stdev * r * sin(theta);
+    }
+
+    // An odd count uses one more pair, whose second variate is dropped
+    if (n % 2 == 1)
+    {
+        values[n - 1] = mean + stdev * sqrt(-2.0 * log(1.0 - values[n - 1])) * cos(2.0 * M_PI * last_u2);
+    }
+}
+
+double neat::geometric(double p)
+{
+    if (p >= 1)
+    {
+        return 0;
+    }
+
+    // Inverse of the cumulative distribution, 1 - randrange() is in (0, 1] to avoid log(0)
+    return floor(log(1.0 - randrange()) / log1p(-p));
+}
@@ -1,8 +1,149 @@
 #ifndef NEAT_MATH_UTILS_HPP
 #define NEAT_MATH_UTILS_HPP
 
+#include <cstdint>
+
 namespace neat
 {
+    /**
+     * @brief xoshiro256** pseudo-random number generator.
+     *
+     * Small and fast engine satisfying the UniformRandomBitGenerator requirements, so it can also be used with the
+     * standard distributions.
+     */
+    class Xoshiro256
+    {
+    public:
+        using result_type = std::uint64_t;
+
+        /**
+         * @brief Constructor for Xoshiro256.
+         * @param seed Seed of the engine.
+         */
+        Xoshiro256(std::uint64_t seed = 0);
+
+        /**
+         * @brief Reseeds the engine, the seed is expanded to the full state with splitmix64.
+         * @param seed Seed of the engine.
+         */
+        void seed(std::uint64_t seed);
+
+        /**
+         * @brief Generates the next 64-bit random number.
+         * @return A random number.
+         */
+        result_type operator()();
+
+        static constexpr result_type min() { return 0; }
+        static constexpr result_type max() { return UINT64_MAX; }
+
+    private:
+        std::uint64_t state[4];
+    };
+
+    /**
+     * @brief Identifies what a random stream is used for, so that different uses of the same genome never share a stream.
+     */
+    enum class RandomPurpose : std::uint32_t
+    {
+        INITIALIZATION,
+        REPRODUCTION
+    };
+
+    /**
+     * @brief Counter-based random number generator (Philox4x32-10).
+     *
+     * The numbers are a pure function of the seed, the (generation, index, purpose) tuple and the position in the
+     * stream, so each tuple derives an independent stream and results don't depend on which thread draws them.
+     */
+    class RandomStream
+    {
+    public:
+        using result_type = std::uint64_t;
+
+        /**
+         * @brief Constructor for RandomStream.
+         * @param seed Seed of the run.
+         * @param generation Generation number.
+         * @param index Index of the genome in the generation.
+         * @param purpose What the stream is used for.
+         */
+        RandomStream(std::uint64_t seed, std::uint32_t generation, std::uint32_t index, RandomPurpose purpose);
+
+        /**
+         * @brief Generates the next 64-bit random number of the stream.
+         * @return A random number.
+         */
+        result_type operator()();
+
+        static constexpr result_type min() { return 0; }
+        static constexpr result_type max() { return UINT64_MAX; }
+
+    private:
+        std::uint32_t key[2];     // Derived from the seed.
+        std::uint32_t counter[4]; // Block number, purpose, index and generation.
+        std::uint32_t block[4];   // Last generated block.
+        int position;             // Number of 64-bit values already used in the block.
+    };
+
+    /**
+     * @brief Makes the random functions of the calling thread draw from a stream during the lifetime of this object.
+     */
+    class ScopedRandomStream
+    {
+    public:
+        /**
+         * @brief Constructor for ScopedRandomStream.
+         * @param seed Seed of the run.
+         * @param generation Generation number.
+         * @param index Index of the genome in the generation.
+         * @param purpose What the stream is used for.
+         */
+        ScopedRandomStream(std::uint64_t seed, std::uint32_t generation, std::uint32_t index, RandomPurpose purpose);
+
+        /**
+         * @brief Destructor for ScopedRandomStream, restores the previous source of random numbers.
+         */
+        ~ScopedRandomStream();
+
+        ScopedRandomStream(const ScopedRandomStream &) = delete;
+        ScopedRandomStream &operator=(const ScopedRandomStream &) = delete;
+
+    private:
+        RandomStream stream;
+        RandomStream *previous;
+    };
+
+    /**
+     * Seeds the random number generation of every thread.
+     * Each thread derives its own engine from this seed and the order in which it first draws a number.
+     *
+     * @param seed The global seed.
+     */
+    void seed(std::uint64_t seed);
+
+    /**
+     * Seeds the random number generation of the calling thread only.
+     *
+     * @param seed The seed of the calling thread's engine.
+     */
+    void seed_thread(std::uint64_t seed);
+
+    /**
+     * Returns the global seed, drawn from the system entropy source unless set with seed().
+     *
+     * @return The global seed.
+     */
+    std::uint64_t get_seed();
+
+    /**
+     * Generates 64 random bits, from the active ScopedRandomStream if there is one, otherwise from the thread-local engine.
+     * All the random functions below draw from it.
+     *
+     * @return A random number.
+     */
+    std::uint64_t random_bits();
+
     /**
      * Generates a random double value in the range [min, max).
      *
@@ -29,6 +170,64 @@ namespace neat
      * @return A random double value from the normal distribution.
      */
     double normal(double mean, double stdev);
+
+    /**
+     * Fills a buffer with random double values from a normal (Gaussian) distribution.
+     * The Box-Muller transform is applied to pairs of uniform values and both of the variates it gives are kept,
+     * so it draws half as many random numbers as calling normal n times.
+     *
+     * @param values The buffer of n values to fill.
+     * @param n The number of values.
+     * @param mean The mean (average) of the distribution.
+     * @param stdev The standard deviation of the distribution.
+     */
+    void normal_n(double *values, int n, double mean, double stdev);
+
+    /**
+     * Generates the number of failures before the first success of independent trials (geometric distribution).
+     *
+     * @param p The probability of success of each trial, in (0, 1].
+     * @return The number of failures, as a double since it can exceed the range of an int.
+     */
+    double geometric(double p);
+
+    // Above this probability, for_each_sampled draws once per index instead of jumping between the chosen indices
+    const double GEOMETRIC_SKIP_MAX_RATE = 0.25;
+
+    /**
+     * Calls f(i) for each index i in [0, n) with probability p, independently, in increasing order.
+     * Low probabilities jump from one chosen index to the next with geometric gaps, so the cost follows the number of
+     * chosen indices rather than n.
+     *
+     * @param n The number of indices.
+     * @param p The probability of choosing each index.
+     * @param f The function called with each chosen index.
+     */
+    template <typename Function>
+    void for_each_sampled(int n, double p, Function f)
+    {
+        if (p <= 0)
+        {
+            return;
+        }
+
+        if (p >= GEOMETRIC_SKIP_MAX_RATE)
+        {
+            for (int i = 0; i < n; ++i)
+            {
+                if (randrange() < p)
+                {
+                    f(i);
+                }
+            }
+            return;
+        }
+
+        for (double i = geometric(p); i < n; i += 1 + geometric(p))
+        {
+            f(static_cast<int>(i));
+        }
+    }
 }
 
-#endif
\ No newline at end of file
+#endif
@@ -1,183 +1,85 @@
 #include <vector>
 #include <cmath>
-#include <iostream>
-#include <algorithm>
+#include <string>
+#include <stdexcept>
 #include "config.hpp"
 #include "activation_functions.hpp"
 #include "math_utils.hpp"
-#include "connection_gene.hpp"
 #include "node.hpp"
 
-neat::Node::Node(int id, ActivationFunction activation_function, int layer) : id(id), input_sum(0), output_value(0), layer(layer), activation_function(activation_function) {}
-
-neat::Node::~Node()
+int neat::NodeGenes::size() const
 {
-    for (auto &c : this->output_connections)
-    {
-        c.reset();
-    }
-
-    this->output_connections.clear();
+    return this->ids.size();
 }
 
-void neat::Node::activate()
+int neat::NodeGenes::index_of(int id) const
 {
-    if (this->layer != 0)
-    {
-        ActivationFunctionPointer activation = get_function(this->activation_function);
-        this->output_value = activation(input_sum);
-    }
+    return id >= 0 && id < static_cast<int>(this->indices.size()) ? this->indices[id] : -1;
 }
 
-void neat::Node::propagate_output()
+void neat::NodeGenes::add(int id, ActivationFunction activation_function, int layer)
 {
-    for (auto &c : this->output_connections)
+    // The id is used as an index in the table, so an id out of bounds (e.g. from a corrupted file) is rejected
+    if (id < 0)
     {
-        if (c->enabled)
-        {
-            c->to_node->input_sum += c->weight * this->output_value;
-        }
+        throw std::invalid_argument("A node can't have a negative id.");
     }
-}
-
-void neat::Node::mutate(const neat::Config &config)
-{
-    if (randrange() < config.activation_mutate_rate)
+    if (id > MAX_NODE_ID)
     {
-        std::vector<ActivationFunction> activations_functions = {
-            "step",
-            "sigmoid",
-            "tanh",
-            "relu",
-            "leaky_relu",
-            "prelu",
-            "elu",
-            "softmax",
-            "linear",
-            "swish"};
-
-        int random_index = floor(randrange() * activations_functions.size());
-        neat::ActivationFunction random_function = activations_functions[random_index];
-
-        while (random_function == this->activation_function)
-        {
-            random_index = floor(randrange() * activations_functions.size());
-            random_function = activations_functions[random_index];
-        }
-
-        this->activation_function = random_function;
+        throw std::invalid_argument("A node id can't be above " + std::to_string(MAX_NODE_ID) + ".");
     }
-}
 
-bool neat::Node::is_connected_to(std::shared_ptr<Node> node)
-{
-    if (node->layer == this->layer)
+    // The ids come from a counter, so the table stays about as large as the number of nodes
+    if (id >= static_cast<int>(this->indices.size()))
     {
-        return false;
+        this->indices.resize(id + 1, -1);
     }
+    this->indices[id] = this->ids.size();
 
-    if (node->layer < this->layer)
-    {
-        for (auto &c : node->output_connections)
-        {
-            if (c->to_node.get() == this)
-            {
-                return true;
-            }
-        }
-    }
-    else
-    {
-        for (auto &c : this->output_connections)
-        {
-            if (c->to_node == node)
-            {
-                return true;
-            }
-        }
-    }
-
-    return false;
+    this->ids.push_back(id);
+    this->layers.push_back(layer);
+    this->activation_functions.push_back(activation_function);
 }
 
-bool neat::Node::is_equal(std::shared_ptr<Node> other)
+void neat::NodeGenes::remove(int index)
 {
-    if (id != other->id || this->activation_function != other->activation_function || this->layer != other->layer)
-    {
-        return false;
-    }
+    this->indices[this->ids[index]] = -1;
+    this->ids.erase(this->ids.begin() + index);
+    this->layers.erase(this->layers.begin() + index);
+    this->activation_functions.erase(this->activation_functions.begin() + index);
 
-    for (auto &connection1 : this->output_connections)
+    // The following nodes moved down by one index
+    for (int i = index; i < this->size(); ++i)
     {
-        bool found = false;
-        for (auto &connection2 : other->output_connections)
-        {
-            if (connection1->is_equal(connection2))
-            {
-                found = true;
-                break;
-            }
-        }
-
-        if (!found)
-        {
-            return false;
-        }
+        this->indices[this->ids[i]] = i;
     }
+}
 
-    return true;
+void neat::NodeGenes::clear()
+{
+    this->ids.clear();
+    this->layers.clear();
+    this->activation_functions.clear();
+    this->indices.clear();
 }
 
-std::shared_ptr<neat::Node> neat::Node::clone()
+void neat::NodeGenes::reserve(int capacity)
 {
-    return std::make_shared<neat::Node>(this->id, this->activation_function, this->layer);
+    this->ids.reserve(capacity);
+    this->layers.reserve(capacity);
+    this->activation_functions.reserve(capacity);
 }
 
-neat::ActivationFunctionPointer neat::Node::get_function(neat::ActivationFunction function)
+void neat::NodeGenes::mutate(const neat::Config &config)
 {
-    if (this->activation_function == "step")
-    {
-        return step;
-    }
-    else if (this->activation_function == "sigmoid")
-    {
-        return sigmoid;
-    }
-    else if (this->activation_function == "tanh")
-    {
-        return tanh;
-    }
-    else if (this->activation_function == "relu")
-    {
-        return relu;
-    }
-    else if (this->activation_function == "leaky_relu")
-    {
-        return leaky_relu;
-    }
-    else if (this->activation_function == "prelu")
-    {
-        return prelu;
-    }
-    else if (this->activation_function == "elu")
-    {
-        return elu;
-    }
-    else if (this->activation_function == "softmax")
-    {
-        return softmax;
-    }
-    else if (this->activation_function == "linear")
-    {
-        return linear;
-    }
-    else if (this->activation_function == "swish")
-    {
-        return swish;
-    }
-    else
-    {
-        std::cerr << "Unknown activation function: " << this->activation_function << std::endl;
-        return sigmoid;
-    }
+    for_each_sampled(this->size(), config.activation_mutate_rate, [&](int index)
+                     {
+                         // Pick one of the other activation functions
+                         int random_index = floor(randrange() * (ACTIVATION_FUNCTIONS_COUNT - 1));
+                         if (random_index >= static_cast<int>(this->activation_functions[index]))
+                         {
+                             ++random_index;
+                         }
+
+                         this->activation_functions[index] = static_cast<ActivationFunction>(random_index); });
 }
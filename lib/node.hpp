@@ -4,83 +4,72 @@
 #include <vector>
 #include "activation_functions.hpp"
 #include "config.hpp"
-#include <memory>
+
 namespace neat
 {
-    // Type alias for the function pointer
-    using ActivationFunctionPointer = double (*)(double);
 
-    class ConnectionGene; // Forward declaration
+    // Largest node id, which bounds the table of the indices of the ids to 64 MB
+    constexpr int MAX_NODE_ID = (1 << 24) - 1;
 
     /**
-     * @brief Represents a node in a neural network.
+     * @brief Represents the nodes of a neural network, stored as parallel contiguous arrays.
+     *
+     * The node at index i is described by ids[i], layers[i] and activation_functions[i].
+     * The arrays must be changed through add, remove and clear, which keep the index of each id up to date.
      */
-    class Node
+    class NodeGenes
     {
     public:
-        int id;                                                          // Unique identifier for the node.
-        double input_sum;                                                // Accumulated input sum for the node.
-        double output_value;                                             // Output value after activation.
-        std::vector<std::shared_ptr<ConnectionGene>> output_connections; // List of outgoing connections.
-        int layer;                                                       // Layer to which the node belongs.
-        neat::ActivationFunction activation_function;                    // Activation function of the node.
+        std::vector<int> ids;                                       // Unique identifier of each node.
+        std::vector<int> layers;                                    // Layer to which each node belongs.
+        std::vector<neat::ActivationFunction> activation_functions; // Activation function of each node.
+        std::vector<int> indices;                                   // Index of the node of each id, -1 for the unused ids.
 
         /**
-         * @brief Constructor for the Node class.
-         * @param id Unique identifier for the node.
-         * @param activation_function Activation function of the node.
-         * @param layer Layer to which the node belongs.
+         * @brief Returns the number of nodes.
+         * @return Number of nodes.
          */
-        Node(int id, ActivationFunction activation_function, int layer);
+        int size() const;
 
         /**
-         * @brief Destructor for the Node class.
+         * @brief Returns the index of a node in constant time.
+         * @param id Unique identifier of the node.
+         * @return Index of the node, -1 if there is no node with this id.
          */
-        ~Node();
+        int index_of(int id) const;
 
         /**
-         * @brief Activate the node using its activation function.
-         */
-        void activate();
-
-        /**
-         * @brief Propagate the output to connected nodes.
-         */
-        void propagate_output();
-
-        /**
-         * @brief Mutates the node's properties based on the NEAT algorithm.
-         * @param config NEAT configuration settings.
+         * @brief Adds a node at the end of the arrays.
+         * @param id Unique identifier for the node.
+         * @param activation_function Activation function of the node.
+         * @param layer Layer to which the node belongs.
+         * @throws std::invalid_argument If the id is negative or above MAX_NODE_ID.
          */
-        void mutate(const Config &config);
+        void add(int id, ActivationFunction activation_function, int layer);
 
         /**
-         * @brief Checks if the node is connected to another node.
-         * @param node Pointer to the target node.
-         * @return True if connected, false otherwise.
+         * @brief Removes a node, the following nodes are shifted down by one index.
+         * @param index Index of the node.
          */
-        bool is_connected_to(std::shared_ptr<Node> node);
+        void remove(int index);
 
         /**
-         * @brief Compare two nodes.
-         * @param other The node to compare with it.
-         * @return True if the nodes are the same and connection genes, otherwise false.
+         * @brief Removes all the nodes, keeping the capacity of the arrays.
          */
-        bool is_equal(std::shared_ptr<Node> other);
+        void clear();
 
         /**
-         * @brief Creates a clone of the node.
-         * @return Pointer to the cloned node.
+         * @brief Reserves room for a number of nodes.
+         * @param capacity Number of nodes.
          */
-        std::shared_ptr<Node> clone();
+        void reserve(int capacity);
 
-    private:
         /**
-         * @brief Retrieves the activation function based on the specified enum.
-         * @param activation_function Activation function specified by the enum.
-         * @return Pointer to the activation function.
+         * @brief Mutates the nodes' properties based on the NEAT algorithm.
+         * Only the nodes picked by the activation mutation rate are visited.
+         * @param config NEAT configuration settings.
          */
-        ActivationFunctionPointer get_function(ActivationFunction function);
+        void mutate(const Config &config);
     };
 
 }
@@ -3,54 +3,74 @@
 #include <vector>
 #include <algorithm>
 #include <functional>
-#include <thread>
 #include <fstream>
 #include <filesystem>
+#include <unordered_map>
 #include "json.hpp"
+#include "math_utils.hpp"
 #include "config.hpp"
 #include "genome.hpp"
-#include "connection_history.hpp"
+#include "innovation_tracker.hpp"
 #include "species.hpp"
+#include "thread_pool.hpp"
+#include "genome_arena.hpp"
 #include "population.hpp"
 
-neat::Population::Population(const Config &config, bool init_genomes) : config(config)
+neat::Population::Population(const Config &config, bool init_genomes) : config(std::make_shared<const Config>(config))
 {
     this->generation = 0;
     this->best_fitness = 0;
     this->average_fitness = 0;
-    this->best_genome = nullptr;
-    this->innovation_history = {};
-    this->species = {};
-    this->genomes = {};
+    this->seed = get_seed();
+    this->thread_pool = std::make_unique<ThreadPool>(this->config->num_threads);
+    this->current_arena = 0;
 
     if (init_genomes)
     {
-        for (int i = 0; i < this->config.population_size; ++i)
+        for (int i = 0; i < this->config->population_size; ++i)
         {
-            Genome *genome = new Genome(config);
-            genome->mutate(this->innovation_history);
+            // Draw the random numbers of each genome from its own stream, so that runs can be replayed
+            ScopedRandomStream stream(this->seed, this->generation, i, RandomPurpose::INITIALIZATION);
+            Genome *genome = this->genome_arenas[this->current_arena].create(this->config);
+            genome->mutate(this->innovation_tracker);
             genome->generate_network();
 
-            if (this->config.initial_connections == "full")
+            if (this->config->initial_connections == InitialConnection::FULL)
             {
-                genome->fully_connect(innovation_history);
+                genome->fully_connect(this->innovation_tracker);
             }
             this->genomes.push_back(genome);
         }
     }
 }
 
-neat::Population::~Population()
+void neat::Population::set_config(const Config &config)
 {
-    // Delete all the dynamically allocated species
-    for (auto sp : this->species)
+    bool resize_thread_pool = config.num_threads != this->config->num_threads;
+    this->config = std::make_shared<const Config>(config);
+    this->fitness_cache.clear();
+    if (resize_thread_pool)
     {
-        delete sp;
+        this->thread_pool = std::make_unique<ThreadPool>(this->config->num_threads);
     }
 
-    // Clear the vectors
-    this->species.clear();
-    this->genomes.clear();
+    // The children inherit the configuration of their parents, so the next generation is built with the new one
+    for (auto &g : this->genomes)
+    {
+        g->config = this->config;
+    }
+    for (auto &s : this->species)
+    {
+        s->champion->config = this->config;
+        for (auto &g : s->genomes)
+        {
+            g->config = this->config;
+        }
+    }
+    if (this->best_genome != nullptr)
+    {
+        this->best_genome->config = this->config;
+    }
 }
 
 void neat::Population::set_best_genome()
@@ -60,27 +80,28 @@ void neat::Population::set_best_genome()
         Genome *temp_best = this->species[0]->genomes[0];
         if (temp_best->fitness >= this->best_fitness)
         {
-            this->best_genome = temp_best;
+            // Keep a copy, as the genomes of a generation are destroyed two generations later
+            this->best_genome.reset(temp_best->clone());
             this->best_fitness = temp_best->fitness;
         }
     }
 }
 
 void neat::Population::run(std::function<void(Genome *, int)> evaluate_genome, int nb_generations, std::function<void(Population *, int)> callback_generation)
+{
+    this->run_batched([&](const std::vector<Genome *> &genomes, int generation)
+                      {
+                          // Evaluate the genomes in parallel on the workers, starting with the largest networks
+                          this->thread_pool->parallel_for(this->get_evaluation_costs(genomes), [&](int j)
+                                                          { evaluate_genome(genomes[j], generation); }); },
+                      nb_generations, callback_generation);
+}
+
+void neat::Population::run_batched(std::function<void(const std::vector<Genome *> &, int)> evaluate_genomes, int nb_generations, std::function<void(Population *, int)> callback_generation)
 {
     for (int i = 0; i < nb_generations; ++i)
     {
-        // Use threads to evaluate genomes in parallel
-        std::vector<std::thread> threads;
-        for (size_t j = 0; j < this->genomes.size(); ++j)
-            threads.emplace_back([&, j]()
-                                 { evaluate_genome(this->genomes[j], i); });
-
-        // Wait for all threads to finish
-        for (auto &thread : threads)
-        {
-            thread.join();
-        }
+        this->evaluate(evaluate_genomes, i);
 
         this->speciate();
         this->sort_species();
@@ -99,7 +120,7 @@ void neat::Population::run(std::function<void(Genome *, int)> evaluate_genome, i
         }
 
         // Stop the algorithm if the fitness threshold is reached
-        if (!this->config.no_fitness_termination && this->best_genome->fitness > this->config.fitness_threshold)
+        if (!this->config->no_fitness_termination && this->best_genome->fitness > this->config->fitness_threshold)
         {
             break;
         }
@@ -112,6 +133,59 @@ void neat::Population::run(std::function<void(Genome *, int)> evaluate_genome, i
     }
 }
 
+std::vector<double> neat::Population::get_evaluation_costs(const std::vector<Genome *> &genomes) const
+{
+    std::vector<double> costs;
+    costs.reserve(genomes.size());
+    for (const auto &g : genomes)
+    {
+        // A feed forward costs one activation per node and one multiply-add per enabled connection
+        int enabled_genes = std::count(g->genes.enabled.begin(), g->genes.enabled.end(), true);
+        costs.push_back(g->nodes.size() + enabled_genes);
+    }
+    return costs;
+}
+
+void neat::Population::evaluate(const std::function<void(const std::vector<Genome *> &, int)> &evaluate_genomes, int generation)
+{
+    if (!this->config->fitness_cache)
+    {
+        evaluate_genomes(this->genomes, generation);
+        return;
+    }
+
+    std::vector<std::uint64_t> hashes(this->genomes.size());
+    this->thread_pool->parallel_for(this->genomes.size(), [&](int i)
+                                    { hashes[i] = this->genomes[i]->hash(); });
+
+    // Only evaluate the genomes that differ from all the genomes of the previous generation
+    std::vector<Genome *> to_evaluate;
+    for (size_t i = 0; i < this->genomes.size(); ++i)
+    {
+        auto it = this->fitness_cache.find(hashes[i]);
+        if (it != this->fitness_cache.end())
+        {
+            this->genomes[i]->fitness = it->second;
+        }
+        else
+        {
+            to_evaluate.push_back(this->genomes[i]);
+        }
+    }
+
+    if (!to_evaluate.empty())
+    {
+        evaluate_genomes(to_evaluate, generation);
+    }
+
+    // Keep the raw fitness of this generation, before it is shared within the species
+    this->fitness_cache.clear();
+    for (size_t i = 0; i < this->genomes.size(); ++i)
+    {
+        this->fitness_cache[hashes[i]] = this->genomes[i]->fitness;
+    }
+}
+
 void neat::Population::speciate()
 {
     // Reset the genomes in each species
@@ -120,29 +194,44 @@ void neat::Population::speciate()
         s->genomes.clear();
     }
 
-    // Group the genomes by species
-    for (auto &g : this->genomes)
+    // Compare the genes of each genome with the champions of the existing species on the workers,
+    // as this part of the compatibility doesn't depend on the genomes already assigned to each species
+    size_t nb_species = this->species.size();
+    std::vector<GenesComparison> comparisons(this->genomes.size() * nb_species);
+    this->thread_pool->parallel_for(this->genomes.size(), [&](int i)
+                                    {
+                                        for (size_t s = 0; s < nb_species; ++s)
+                                        {
+                                            comparisons[i * nb_species + s] = this->species[s]->compare_genes(this->genomes[i], this->species[s]->champion.get());
+                                        }
+                                    });
+
+    // Group the genomes by species in order, so that the result doesn't depend on the number of workers
+    for (size_t i = 0; i < this->genomes.size(); ++i)
     {
+        Genome *g = this->genomes[i];
         bool species_found = false;
 
-        for (auto &s : this->species)
+        for (size_t s = 0; s < this->species.size(); ++s)
         {
-            if (s->same_species(g, this->config))
+            // The species created during this loop are compared on the spot
+            bool same_species = s < nb_species ? this->species[s]->same_species(comparisons[i * nb_species + s], g, *this->config)
+                                               : this->species[s]->same_species(g, *this->config);
+            if (same_species)
             {
-                s->add_to_species(g);
+                this->species[s]->add_to_species(g);
                 species_found = true;
                 break;
             }
         }
         if (!species_found)
         {
-            Species *new_species = new Species(g);
-            this->species.push_back(new_species);
+            this->species.push_back(std::make_unique<Species>(g));
         }
     }
 
     // Remove the empty species
-    auto it = std::remove_if(this->species.begin(), this->species.end(), [](const Species *s)
+    auto it = std::remove_if(this->species.begin(), this->species.end(), [](const std::unique_ptr<Species> &s)
                              { return s->genomes.empty(); });
     this->species.erase(it, this->species.end());
 }
@@ -153,15 +242,33 @@ void neat::Population::reproduce_species()
     float average_fitness_sum = get_average_fitness_sum();
 
     // Get the target population size from the configuration
-    int population_size = config.population_size;
+    int population_size = this->config->population_size;
 
-    // Create a vector to store the new generation of genomes
-    std::vector<Genome *> children;
+    // Only the identical mutations of the same generation share their innovation numbers
+    this->innovation_tracker.reset();
+
+    // Build the new generation in the arena of the previous one, which isn't referenced anymore
+    int next_arena = 1 - this->current_arena;
+    GenomeArena &arena = this->genome_arenas[next_arena];
+    arena.reset();
+
+    // Plan the new generation, so that the children can then be built in any order:
+    // each child is either a copy of a genome, or a baby of a species
+    struct ChildPlan
+    {
+        Genome *genome;   // Genome to copy, nullptr for a baby.
+        Species *species; // Species giving birth to the baby.
+    };
+    std::vector<ChildPlan> plans;
+    plans.reserve(population_size);
 
     for (auto &s : this->species)
     {
         // Clone the champion of each species and add it to the new generation
-        children.push_back(s->champion->clone());
+        plans.push_back({s->champion.get(), nullptr});
+
+        // Build the selection table of the species once for all its children
+        s->prepare_selection(*this->config);
 
         // Calculate the number of children based on the species' contribution to the total average fitness
         int nb_of_children = (average_fitness_sum == 0) ? 0 : std::floor((s->average_fitness / average_fitness_sum) * population_size) - 1;
@@ -169,34 +276,56 @@ void neat::Population::reproduce_species()
         // Generate babies and add them to the new generation
         for (int i = 0; i < nb_of_children; ++i)
         {
-            children.push_back(s->give_me_baby(this->innovation_history));
+            plans.push_back({nullptr, s.get()});
         }
     }
 
     // Clone the best genome from the previous generation and add it to the new generation
-    Genome *previous_best = genomes[0];
-    if (children.size() < static_cast<size_t>(population_size))
+    if (!this->genomes.empty() && plans.size() < static_cast<size_t>(population_size))
     {
-        children.push_back(previous_best->clone());
+        plans.push_back({this->genomes[0], nullptr});
     }
 
-    // If there are still not enough babies, get babies from the best species until reaching the target population size
-    while (children.size() < static_cast<size_t>(population_size))
+    // If there are still not enough babies, get babies from the best species until reaching the target population size.
+    // If all the species went extinct, reset_on_extinction rebuilds the population instead.
+    while (!this->species.empty() && plans.size() < static_cast<size_t>(population_size))
     {
-        children.push_back(species[0]->give_me_baby(this->innovation_history));
+        plans.push_back({nullptr, species[0].get()});
+    }
+
+    // Build the children on the workers. Each baby draws from its own random stream and numbers its new connections
+    // with its own provisional tracker, so that the result doesn't depend on the scheduling of the threads.
+    int first_provisional_nb = this->innovation_tracker.get_next_innovation_nb();
+    std::vector<InnovationTracker> provisional_trackers(plans.size(), InnovationTracker(first_provisional_nb));
+    std::vector<Genome *> children(plans.size());
+    this->thread_pool->parallel_for(plans.size(), [&](int i)
+                                    {
+                                        if (plans[i].genome != nullptr)
+                                        {
+                                            children[i] = plans[i].genome->clone(&arena);
+                                            return;
+                                        }
+
+                                        ScopedRandomStream stream(this->seed, this->generation, i, RandomPurpose::REPRODUCTION);
+                                        children[i] = plans[i].species->give_me_baby(provisional_trackers[i], &arena); });
+
+    // Give the new connections their final innovation numbers in the order of the children,
+    // so identical mutations of the same generation still share their numbers
+    for (size_t i = 0; i < children.size(); ++i)
+    {
+        children[i]->genes.renumber(first_provisional_nb, this->innovation_tracker.resolve(provisional_trackers[i], first_provisional_nb));
     }
 
     // Update the population's genomes with the new generation
     this->genomes = children;
+    this->current_arena = next_arena;
 
     // Increment the generation counter
     ++this->generation;
 
     // Generate neural networks for each genome in the new generation
-    for (auto &g : this->genomes)
-    {
-        g->generate_network();
-    }
+    this->thread_pool->parallel_for(this->genomes.size(), [this](int i)
+                                    { this->genomes[i]->generate_network(); });
 
     // Set the best genome in the population
     this->set_best_genome();
@@ -209,18 +338,18 @@ void neat::Population::sort_species()
         s->sort_genomes();
     }
 
-    std::sort(this->species.begin(), this->species.end(), [](const Species *s1, const Species *s2)
+    std::sort(this->species.begin(), this->species.end(), [](const std::unique_ptr<Species> &s1, const std::unique_ptr<Species> &s2)
               { return s1->best_fitness > s2->best_fitness; });
 }
 
 void neat::Population::kill_stagnant_species()
 {
     // Use remove_if along with a lambda function to filter out stagnant species
-    auto it = std::remove_if(this->config.species_elitism < species.size() ? this->species.begin() + this->config.species_elitism : this->species.begin(), this->species.end(), [this](const Species *s)
-                             { if (s->stagnation >= this->config.max_stagnation)
+    auto it = std::remove_if(this->config->species_elitism < species.size() ? this->species.begin() + this->config->species_elitism : this->species.begin(), this->species.end(), [this](const std::unique_ptr<Species> &s)
+                             { if (s->stagnation >= this->config->max_stagnation)
                                  {
                                      // Remove genomes of the stagnant species
-                                     this->genomes.erase(std::remove_if(this->genomes.begin(), this->genomes.end(), [s](const Genome *g)
+                                     this->genomes.erase(std::remove_if(this->genomes.begin(), this->genomes.end(), [&s](const Genome *g)
                                                                   { return std::find(s->genomes.begin(), s->genomes.end(), g) != s->genomes.end(); }),
                                                    genomes.end());
                                      return true; // Remove the stagnant species
@@ -236,12 +365,12 @@ void neat::Population::kill_bad_species()
     float species_average_fitness = this->get_average_fitness_sum() / this->species.size();
 
     // Use remove_if along with a lambda function to filter out bad species
-    auto it = std::remove_if(this->species.size() > 1 ? this->species.begin() + 1 : this->species.begin(), this->species.end(), [this, species_average_fitness](const Species *s)
+    auto it = std::remove_if(this->species.size() > 1 ? this->species.begin() + 1 : this->species.begin(), this->species.end(), [this, species_average_fitness](const std::unique_ptr<Species> &s)
                              { 
-                                 if (s->average_fitness < species_average_fitness * this->config.bad_species_threshold)
+                                 if (s->average_fitness < species_average_fitness * this->config->bad_species_threshold)
                                  {
                                      // Remove genomes of the bad species from the genomes vector
-                                     this->genomes.erase(std::remove_if(this->genomes.begin(), this->genomes.end(), [s](const Genome *g)
+                                     this->genomes.erase(std::remove_if(this->genomes.begin(), this->genomes.end(), [&s](const Genome *g)
                                                                  { return std::find(s->genomes.begin(), s->genomes.end(), g) != s->genomes.end(); }), this->genomes.end());
 
                                      return true; // Remove the bad species
@@ -259,9 +388,9 @@ void neat::Population::reset_on_extinction()
         this->genomes.clear();
 
         // Reinitialize with new genomes
-        for (int i = 0; i < this->config.population_size; ++i)
+        for (int i = 0; i < this->config->population_size; ++i)
         {
-            this->genomes.push_back(new Genome(this->config));
+            this->genomes.push_back(this->genome_arenas[this->current_arena].create(this->config));
         }
     }
 }
@@ -285,7 +414,7 @@ void neat::Population::update_species()
 {
     for (auto &s : this->species)
     {
-        s->kill_genomes(this->config);
+        s->kill_genomes(*this->config);
         s->fitness_sharing();
         s->set_average_fitness();
     }
@@ -293,31 +422,48 @@ void neat::Population::update_species()
 
 neat::Population *neat::Population::clone()
 {
-    Population *clone = new Population(this->config);
-    clone->genomes = {};
-    clone->species = {};
+    Population *clone = new Population(*this->config, false);
+    clone->config = this->config;
+    GenomeArena &arena = clone->genome_arenas[clone->current_arena];
 
-    // Clone the species
-    for (auto &s : this->species)
+    // Clone each genome once, even if it is referenced by both the population and a species
+    std::unordered_map<const Genome *, Genome *> clones;
+    auto clone_genome = [&](Genome *g)
     {
-        clone->species.push_back(s->clone());
+        auto it = clones.find(g);
+        if (it != clones.end())
+        {
+            return it->second;
+        }
+        return clones[g] = g->clone(&arena);
+    };
+
+    for (auto &g : this->genomes)
+    {
+        clone->genomes.push_back(clone_genome(g));
     }
 
-    // Add the genomes of cloned species to the population
+    // Clone the species
     for (auto &s : this->species)
     {
-        for (auto &g : s->genomes)
-            clone->genomes.push_back(g);
+        std::unique_ptr<Species> species_clone(s->clone());
+        for (auto &g : species_clone->genomes)
+        {
+            g = clone_genome(g);
+        }
+        clone->species.push_back(std::move(species_clone));
     }
 
     clone->generation = this->generation;
     clone->average_fitness = this->average_fitness;
     clone->best_fitness = this->best_fitness;
-    clone->innovation_history = this->innovation_history;
+    clone->innovation_tracker = this->innovation_tracker;
+    clone->seed = this->seed;
+    clone->fitness_cache = this->fitness_cache;
 
     if (this->best_genome != nullptr)
     {
-        clone->best_genome = this->best_genome->clone();
+        clone->best_genome.reset(this->best_genome->clone());
     }
 
     return clone;
@@ -351,6 +497,8 @@ void neat::Population::save(const std::string &filename)
         json["generation"] = this->generation;
         json["average_fitness"] = this->average_fitness;
         json["best_fitness"] = this->best_fitness;
+        json["seed"] = this->seed;
+        json["next_innovation_nb"] = this->innovation_tracker.get_next_innovation_nb();
 
         // Save the best genome
         if (best_genome != nullptr)
@@ -392,45 +540,66 @@ neat::Population *neat::Population::load(const std::string &filename, const Conf
         nlohmann::json population_json;
         file >> population_json;
 
-        // Create a new Population object
-        Population *loadedPopulation = new Population(config, false);
+        // Create a new Population object, freed if the file can't be read
+        std::unique_ptr<Population> loadedPopulation = std::make_unique<Population>(config, false);
 
         // Deserialize simple data members
         loadedPopulation->best_fitness = population_json["best_fitness"];
         loadedPopulation->average_fitness = population_json["average_fitness"];
         loadedPopulation->generation = population_json["generation"];
+        if (population_json.contains("seed"))
+        {
+            loadedPopulation->seed = population_json["seed"];
+        }
 
         if (population_json.contains("best_genome"))
         {
             // Deserialize the champion genome
             nlohmann::json best_genome_json = population_json["best_genome"];
 
-            // Create a new Genome object from the JSON data
-            Genome *champion = Genome::from_json(best_genome_json);
-
-            // Set the best genome
-            loadedPopulation->best_genome = champion;
+            // Create a new Genome object from the JSON data and set it as the best genome
+            loadedPopulation->best_genome.reset(Genome::from_json(best_genome_json, loadedPopulation->config));
         }
 
+        // The loaded genomes are created in the arena of the population, which owns them
+        GenomeArena &arena = loadedPopulation->genome_arenas[loadedPopulation->current_arena];
+
         // Deserialize the species
         nlohmann::json species_json = population_json["species"];
         for (const auto &s : species_json)
         {
-            Species *species = Species::from_json(s);
-            loadedPopulation->species.push_back(species);
+            std::unique_ptr<Species> species(Species::from_json(s, loadedPopulation->config, arena));
+            loadedPopulation->species.push_back(std::move(species));
         }
 
         // Deserialize the genomes
         nlohmann::json genomes_json = population_json["genomes"];
         for (const auto &g : genomes_json)
         {
-            Genome *genome = Genome::from_json(g);
-            genome->config = config; // Set the configuration settings
+            Genome *genome = Genome::from_json(g, loadedPopulation->config, &arena);
             loadedPopulation->genomes.push_back(genome);
         }
 
+        // Resume the innovation numbers after the ones already used
+        if (population_json.contains("next_innovation_nb"))
+        {
+            loadedPopulation->innovation_tracker.set_next_innovation_nb(population_json["next_innovation_nb"]);
+        }
+        else
+        {
+            int next_innovation_nb = 1;
+            for (auto &g : loadedPopulation->genomes)
+            {
+                for (int innovation_nb : g->genes.innovation_nbs)
+                {
+                    next_innovation_nb = std::max(next_innovation_nb, innovation_nb + 1);
+                }
+            }
+            loadedPopulation->innovation_tracker.set_next_innovation_nb(next_innovation_nb);
+        }
+
         std::cout << "Population loaded from '" << filename << "'" << std::endl;
-        return loadedPopulation;
+        return loadedPopulation.release();
     }
     catch (const std::exception &e)
     {
@@ -3,11 +3,17 @@
 
 #include <cmath>
 #include <cstdlib>
+#include <cstdint>
 #include <algorithm>
 #include <functional>
+#include <memory>
+#include <array>
+#include <unordered_map>
 #include "genome.hpp"
 #include "species.hpp"
-#include "connection_history.hpp"
+#include "innovation_tracker.hpp"
+#include "thread_pool.hpp"
+#include "genome_arena.hpp"
 
 namespace neat
 {
@@ -15,18 +21,27 @@ namespace neat
     /**
      * @class Population
      * @brief Represents a population of genomes evolving through the NEAT (NeuroEvolution of Augmenting Topologies) algorithm.
+     *
+     * The genomes of a generation live in one of two arenas, which takes turns building the next generations:
+     * a Genome* from genomes, or given to an evaluator or a callback, is destroyed or reused two generations later.
+     * Clone a genome to keep it longer, as best_genome and the species champions do.
      */
     class Population
     {
     public:
-        Config config;                                                      // NEAT configuration settings.
-        std::vector<Genome *> genomes;                                      // List of genomes in the population.
-        Genome *best_genome;                                                // Best genome in the population.
+        std::shared_ptr<const Config> config;                               // NEAT configuration settings, shared by the genomes.
+        std::vector<Genome *> genomes;                                      // List of genomes in the population, owned by the arenas and reused two generations later.
+        std::unique_ptr<Genome> best_genome;                                // Copy of the best genome in the population.
         int generation;                                                     // Current generation number.
         double best_fitness;                                                // Fitness of the best genome.
         double average_fitness;                                             // Average fitness of the population.
-        std::vector<std::shared_ptr<ConnectionHistory>> innovation_history; // List of connection history to track innovations.
-        std::vector<Species *> species;                                     // List of species within the population.
+        InnovationTracker innovation_tracker;                               // Innovations of the population, shared by all the genomes.
+        std::vector<std::unique_ptr<Species>> species;                      // List of species within the population.
+        std::uint64_t seed;                                                 // Seed of the run, from which the random stream of each genome is derived.
+        std::unique_ptr<ThreadPool> thread_pool;                            // Workers evaluating, speciating and reproducing the genomes.
+        std::array<GenomeArena, 2> genome_arenas;                           // Genomes of the current and of the previous generation.
+        int current_arena;                                                  // Index of the arena holding the current generation.
+        std::unordered_map<std::uint64_t, double> fitness_cache;            // Raw fitness of the last evaluated genomes, by hash, if config->fitness_cache.
 
         /**
          * @brief Constructor for the Population class.
@@ -36,9 +51,11 @@ namespace neat
         Population(const Config &config, bool init_genomes = true);
 
         /**
-         * @brief Destructor for the Population class to ensure proper cleanup.
+         * @brief Replaces the configuration of the population, to be called between two generations.
+         * The current genomes switch to the new configuration at once, so the next generation is entirely built with it.
+         * @param config NEAT configuration settings.
          */
-        ~Population();
+        void set_config(const Config &config);
 
         /**
          * @brief Sets the best genome based on the current species.
@@ -47,12 +64,37 @@ namespace neat
 
         /**
          * @brief Runs the NEAT algorithm for a specified number of generations.
+         * The genomes given to the evaluator and the callback are only valid for two generations.
          * @param evaluate_genome Function for evaluating the fitness of a genome.
          * @param nb_generations Number of generations to run the algorithm.
          * @param callback_generation Callback function for each generation (optional).
          */
         void run(std::function<void(Genome *, int)> evaluate_genome, int nb_generations, std::function<void(Population *, int)> callback_generation = nullptr);
 
+        /**
+         * @brief Runs the NEAT algorithm for a specified number of generations, evaluating each generation with a single call.
+         * The evaluator gets all the genomes at once, so it can score them on the same input batch and reuse its buffers.
+         * The genomes given to the evaluator and the callback are only valid for two generations.
+         * @param evaluate_genomes Function for evaluating the fitness of all the genomes of a generation.
+         * @param nb_generations Number of generations to run the algorithm.
+         * @param callback_generation Callback function for each generation (optional).
+         */
+        void run_batched(std::function<void(const std::vector<Genome *> &, int)> evaluate_genomes, int nb_generations, std::function<void(Population *, int)> callback_generation = nullptr);
+
+        /**
+         * @brief Estimates the cost of evaluating each genome from the size of its network.
+         * @param genomes Genomes to evaluate.
+         * @return Estimated cost of each genome, in the order of the genomes.
+         */
+        std::vector<double> get_evaluation_costs(const std::vector<Genome *> &genomes) const;
+
+        /**
+         * @brief Evaluates the genomes of the generation, skipping the ones found in the fitness cache if it is enabled.
+         * @param evaluate_genomes Function for evaluating the fitness of the given genomes.
+         * @param generation Current generation number.
+         */
+        void evaluate(const std::function<void(const std::vector<Genome *> &, int)> &evaluate_genomes, int generation);
+
         /**
          * @brief Groups the genomes into species based on their compatibility.
          */
@@ -100,8 +142,8 @@ namespace neat
         void update_species();
 
         /**
-         * @brief Return a copy of this population.
-         * @return A copy of this population.
+         * @brief Return a copy of this population, with its own copies of the genomes.
+         * @return A copy of this population, owned by the caller.
          */
         Population *clone();
 
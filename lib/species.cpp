@@ -2,15 +2,17 @@
 #include <cmath>
 #include <cstdlib>
 #include <algorithm>
+#include <numeric>
 #include <fstream>
 #include <filesystem>
+#include <stdexcept>
 #include "json.hpp"
+#include "math_utils.hpp"
 #include "genome.hpp"
 #include "species.hpp"
 
 neat::Species::Species()
 {
-    this->champion = nullptr;
     this->best_fitness = 0;
     this->average_fitness = 0;
     this->stagnation = 0;
@@ -23,34 +25,31 @@ neat::Species::Species(Genome *genome)
         throw std::invalid_argument("Creating a species with a null genome.");
     }
 
-    this->champion = genome;
+    this->champion.reset(genome->clone());
     this->best_fitness = genome->fitness;
     this->average_fitness = 0;
     this->stagnation = 0;
     this->genomes.push_back(genome);
 }
 
-neat::Species::~Species()
-{
-    for (auto &genome : this->genomes)
-    {
-        delete genome;
-    }
-}
-
 void neat::Species::add_to_species(Genome *genome)
 {
     this->genomes.push_back(genome);
 }
 
 bool neat::Species::same_species(Genome *genome, const Config &config)
+{
+    return this->same_species(this->compare_genes(genome, this->champion.get()), genome, config);
+}
+
+bool neat::Species::same_species(const GenesComparison &comparison, Genome *genome, const Config &config)
 {
     float compatibility_threshold = config.compatibility_threshold;
     float compatibility_disjoint_coefficient = config.compatibility_disjoint_coefficient;
     float compatibility_weight_coefficient = config.compatibility_weight_coefficient;
 
-    int excess_and_disjoint = get_excess_disjoint_genes(genome, this->champion);
-    float avg_weight_diff = average_weight_diff(genome, this->champion);
+    int excess_and_disjoint = comparison.excess + comparison.disjoint;
+    float avg_weight_diff = average_weight_diff(comparison, genome, this->champion.get());
 
     int large_genome_normalizer = this->genomes.size() - 20;
     if (large_genome_normalizer < 1)
@@ -65,53 +64,67 @@ bool neat::Species::same_species(Genome *genome, const Config &config)
     return compatibility_threshold > compatibility;
 }
 
-int neat::Species::get_excess_disjoint_genes(Genome *genome1, Genome *genome2)
+neat::GenesComparison neat::Species::compare_genes(const Genome *genome1, const Genome *genome2) const
 {
-    int matching = 0;
-    for (auto &g1 : genome1->genes)
+    const std::vector<int> &innovation_nbs1 = genome1->genes.innovation_nbs;
+    const std::vector<int> &innovation_nbs2 = genome2->genes.innovation_nbs;
+    GenesComparison comparison = {0, 0, 0, 0};
+
+    // Walk both sorted gene lists at once, as in a merge, pairing repeated innovation numbers in order
+    size_t i = 0;
+    size_t j = 0;
+    while (i < innovation_nbs1.size() && j < innovation_nbs2.size())
     {
-        for (auto &g2 : genome2->genes)
+        if (innovation_nbs1[i] == innovation_nbs2[j])
         {
-            if (g1->innovation_nb == g2->innovation_nb)
-            {
-                matching++;
-                break;
-            }
+            comparison.matching++;
+            comparison.weight_diff += std::abs(genome1->genes.weights[i] - genome2->genes.weights[j]);
+            ++i;
+            ++j;
+        }
+        else if (innovation_nbs1[i] < innovation_nbs2[j])
+        {
+            comparison.disjoint++;
+            ++i;
+        }
+        else
+        {
+            comparison.disjoint++;
+            ++j;
         }
     }
 
-    return genome1->genes.size() + genome2->genes.size() - 2 * matching;
+    // The genes left in one genome are beyond the last innovation number of the other one
+    comparison.excess = (innovation_nbs1.size() - i) + (innovation_nbs2.size() - j);
+
+    return comparison;
+}
+
+int neat::Species::get_excess_disjoint_genes(Genome *genome1, Genome *genome2)
+{
+    GenesComparison comparison = this->compare_genes(genome1, genome2);
+    return comparison.excess + comparison.disjoint;
 }
 
 float neat::Species::average_weight_diff(Genome *genome1, Genome *genome2)
 {
-    if (genome1->genes.empty() || genome2->genes.empty())
-    {
-        return 0;
-    }
+    return average_weight_diff(this->compare_genes(genome1, genome2), genome1, genome2);
+}
 
-    int matching = 0;
-    float total_diff = 0;
-    for (auto &g1 : genome1->genes)
+float neat::Species::average_weight_diff(const GenesComparison &comparison, Genome *genome1, Genome *genome2)
+{
+    if (genome1->genes.size() == 0 || genome2->genes.size() == 0)
     {
-        for (auto &g2 : genome2->genes)
-        {
-            if (g1->innovation_nb == g2->innovation_nb)
-            {
-                matching++;
-                total_diff += std::abs(g1->weight - g2->weight);
-                break;
-            }
-        }
+        return 0;
     }
 
-    if (matching == 0)
+    if (comparison.matching == 0)
     {
         // Divide by 0 error
         return 100;
     }
 
-    return total_diff / matching;
+    return comparison.weight_diff / comparison.matching;
 }
 
 void neat::Species::sort_genomes()
@@ -123,7 +136,7 @@ void neat::Species::sort_genomes()
     {
         this->stagnation = 0;
         this->best_fitness = genomes[0]->fitness;
-        this->champion = genomes[0]->clone();
+        this->champion.reset(genomes[0]->clone());
     }
     else
     {
@@ -141,12 +154,12 @@ void neat::Species::set_average_fitness()
     average_fitness = sum / this->genomes.size();
 }
 
-neat::Genome *neat::Species::give_me_baby(std::vector<std::shared_ptr<ConnectionHistory>> innovation_history)
+neat::Genome *neat::Species::give_me_baby(InnovationTracker &innovation_tracker, GenomeArena *arena) const
 {
     Genome *baby;
-    if (rand() / static_cast<float>(RAND_MAX) < 0.25)
+    if (randrange() < 0.25)
     {
-        baby = select_genome()->clone();
+        baby = select_genome()->clone(arena);
     }
     else
     {
@@ -157,37 +170,85 @@ neat::Genome *neat::Species::give_me_baby(std::vector<std::shared_ptr<Connection
         // The crossover function expects the highest fitness parent to be the object and the lowest as the argument
         if (parent1->fitness < parent2->fitness)
         {
-            baby = parent2->crossover(parent1);
+            baby = parent2->crossover(parent1, arena);
         }
         else
         {
-            baby = parent1->crossover(parent2);
+            baby = parent1->crossover(parent2, arena);
         }
     }
 
-    baby->mutate(innovation_history);
+    baby->mutate(innovation_tracker);
     return baby;
 }
 
-neat::Genome *neat::Species::select_genome()
+void neat::Species::prepare_selection(const Config &config)
+{
+    this->selection_type = config.selection_type;
+    this->tournament_size = std::max(1, config.tournament_size);
+    this->update_cumulative_weights();
+}
+
+void neat::Species::update_cumulative_weights()
 {
-    float fitness_sum = 0;
-    for (size_t i = 0; i < this->genomes.size(); ++i)
+    this->cumulative_weights.assign(this->genomes.size(), 0);
+
+    if (this->selection_type == SelectionType::RANK)
     {
-        fitness_sum += this->genomes[i]->fitness;
+        // The fittest genome gets a weight of n, the least fit a weight of 1
+        std::vector<int> order(this->genomes.size());
+        std::iota(order.begin(), order.end(), 0);
+        std::stable_sort(order.begin(), order.end(), [&](int i, int j)
+                         { return this->genomes[i]->fitness > this->genomes[j]->fitness; });
+        for (size_t rank = 0; rank < order.size(); ++rank)
+        {
+            this->cumulative_weights[order[rank]] = order.size() - rank;
+        }
     }
+    else
+    {
+        for (size_t i = 0; i < this->genomes.size(); ++i)
+        {
+            this->cumulative_weights[i] = std::max(0.0, this->genomes[i]->fitness);
+        }
+    }
+
+    std::partial_sum(this->cumulative_weights.begin(), this->cumulative_weights.end(), this->cumulative_weights.begin());
+}
 
-    float running_sum = 0;
-    for (size_t i = 0; i < this->genomes.size(); ++i)
+neat::Genome *neat::Species::select_genome() const
+{
+    if (this->selection_type == SelectionType::TOURNAMENT)
     {
-        running_sum += this->genomes[i]->fitness;
-        if (running_sum > rand() / static_cast<float>(RAND_MAX) * fitness_sum)
+        // Keep the fittest of a few genomes drawn at random
+        Genome *winner = this->genomes[randrange(0, this->genomes.size())];
+        for (int i = 1; i < this->tournament_size; ++i)
         {
-            return this->genomes[i];
+            Genome *challenger = this->genomes[randrange(0, this->genomes.size())];
+            if (challenger->fitness > winner->fitness)
+            {
+                winner = challenger;
+            }
         }
+        return winner;
+    }
+
+    // The table is shared by the workers building the children, so it must have been built beforehand by prepare_selection
+    if (this->cumulative_weights.size() != this->genomes.size())
+    {
+        throw std::logic_error("The selection table of the species is out of date, prepare_selection must be called after its genomes changed.");
+    }
+
+    double weights_sum = this->cumulative_weights.empty() ? 0 : this->cumulative_weights.back();
+    if (weights_sum <= 0)
+    {
+        return this->genomes[0];
     }
 
-    return this->genomes[0];
+    // Find the first genome whose running sum exceeds the random draw
+    double target = randrange() * weights_sum;
+    size_t index = std::upper_bound(this->cumulative_weights.begin(), this->cumulative_weights.end(), target) - this->cumulative_weights.begin();
+    return this->genomes[std::min(index, this->genomes.size() - 1)];
 }
 
 void neat::Species::kill_genomes(const Config &config)
@@ -240,7 +301,8 @@ bool neat::Species::is_equal(Species *other)
 
 neat::Species *neat::Species::clone()
 {
-    Species *clone = new Species(this->champion->clone());
+    Species *clone = new Species();
+    clone->champion.reset(this->champion->clone());
     clone->average_fitness = this->average_fitness;
     clone->best_fitness = this->best_fitness;
     clone->stagnation = this->stagnation;
@@ -270,21 +332,21 @@ nlohmann::json neat::Species::to_json() const
     return species_json;
 }
 
-neat::Species *neat::Species::from_json(const nlohmann::json &json)
+neat::Species *neat::Species::from_json(const nlohmann::json &json, const std::shared_ptr<const Config> &config, GenomeArena &arena)
 {
-    Species *species = new Species();
+    std::unique_ptr<Species> species = std::make_unique<Species>();
     species->best_fitness = json["best_fitness"];
     species->average_fitness = json["average_fitness"];
     species->stagnation = json["stagnation"];
-    species->champion = Genome::from_json(json["champion"]);
+    species->champion.reset(Genome::from_json(json["champion"], config));
 
     for (const auto &genome_json : json["genomes"])
     {
-        Genome *genome = Genome::from_json(genome_json);
+        Genome *genome = Genome::from_json(genome_json, config, &arena);
         species->genomes.push_back(genome);
     }
 
-    return species;
+    return species.release();
 }
 void neat::Species::save(const std::string &file_path)
 {
@@ -323,7 +385,7 @@ void neat::Species::save(const std::string &file_path)
     }
 }
 
-neat::Species *neat::Species::load(const std::string &file_path)
+neat::Species *neat::Species::load(const std::string &file_path, const std::shared_ptr<const Config> &config, GenomeArena &arena)
 {
     try
     {
@@ -333,7 +395,7 @@ neat::Species *neat::Species::load(const std::string &file_path)
         file >> species_json;
 
         // Create a new Species object
-        Species *loadedSpecies = neat::Species::from_json(species_json);
+        Species *loadedSpecies = neat::Species::from_json(species_json, config, arena);
 
         std::cout << "Species loaded from '" << file_path << "'" << std::endl;
         return loadedSpecies;
@@ -2,24 +2,40 @@
 #define SPECIES_H
 
 #include <vector>
+#include <memory>
 #include "genome.hpp"
 #include "config.hpp"
-#include "connection_history.hpp"
+#include "innovation_tracker.hpp"
 
 namespace neat
 {
 
+    /**
+     * @brief Result of the comparison of the connection genes of two genomes.
+     */
+    struct GenesComparison
+    {
+        int excess;        // Number of genes beyond the last innovation number of the other genome.
+        int disjoint;      // Number of non-matching genes within the innovation range of the other genome.
+        int matching;      // Number of innovation numbers present in both genomes.
+        float weight_diff; // Sum of the absolute weight differences between matching genes.
+    };
+
     /**
      * @brief Represents a species of genomes in the NEAT algorithm for evolving neural networks.
      */
     class Species
     {
     public:
-        std::vector<Genome *> genomes; //  List of genomes in the species.
-        Genome *champion;              //  The best genome in the species.
-        double best_fitness;           //  Best fitness in the species.
-        double average_fitness;        //  Average fitness of the genomes in the species.
-        int stagnation;                //  Number of generations the species has gone without an improvement.
+        std::vector<Genome *> genomes;    //  List of genomes in the species, owned by the population.
+        std::unique_ptr<Genome> champion; //  Copy of the best genome in the species.
+        double best_fitness;              //  Best fitness in the species.
+        double average_fitness;           //  Average fitness of the genomes in the species.
+        int stagnation;                   //  Number of generations the species has gone without an improvement.
+
+        SelectionType selection_type = SelectionType::ROULETTE; //  Strategy used to select the parents.
+        int tournament_size = 3;                                //  Number of genomes competing in each tournament.
+        std::vector<double> cumulative_weights;                 //  Running sum of the selection weights of the genomes.
 
         Species();
 
@@ -29,11 +45,6 @@ namespace neat
          */
         Species(Genome *genome);
 
-        /**
-         * @brief Deconstructor for Species instance.
-         */
-        ~Species();
-
         /**
          * @brief Adds a genome to the species.
          * @param genome The genome to add to the species.
@@ -48,6 +59,23 @@ namespace neat
          */
         bool same_species(Genome *genome, const Config &config);
 
+        /**
+         * @brief Checks if the genome belongs to this species, from the comparison of its genes with the champion's.
+         * @param comparison The comparison of the genes of the genome with the genes of the champion.
+         * @param genome The genome to check.
+         * @param config NEAT configuration settings.
+         * @return True if the genome is in this species, False otherwise.
+         */
+        bool same_species(const GenesComparison &comparison, Genome *genome, const Config &config);
+
+        /**
+         * @brief Compares the genes of two genomes in a single pass over their genes sorted by innovation number.
+         * @param genome1 The first genome.
+         * @param genome2 The second genome.
+         * @return The excess, disjoint and matching genes and the total weight difference of the matching genes.
+         */
+        GenesComparison compare_genes(const Genome *genome1, const Genome *genome2) const;
+
         /**
          * @brief Returns the number of excess and disjoint genes between two genomes.
          * i.e., returns the number of genes which don't match.
@@ -65,6 +93,15 @@ namespace neat
          */
         float average_weight_diff(Genome *genome1, Genome *genome2);
 
+        /**
+         * @brief Returns the average weight difference between matching genes in two genomes, from their comparison.
+         * @param comparison The comparison of the genes of both genomes.
+         * @param genome1 The first genome.
+         * @param genome2 The second genome.
+         * @return The average weight difference.
+         */
+        float average_weight_diff(const GenesComparison &comparison, Genome *genome1, Genome *genome2);
+
         /**
          * @brief Sorts genomes in the species by fitness.
          */
@@ -76,17 +113,33 @@ namespace neat
         void set_average_fitness();
 
         /**
-         * @brief Gets a baby genome from the genomes in this species.
-         * @param innovation_history List of connection history to track innovations.
+         * @brief Gets a baby genome from the genomes in this species, with the selection table built by prepare_selection.
+         * The species is only read, so several babies of the same species can be made at the same time.
+         * @param innovation_tracker Innovations of the population.
+         * @param arena Arena in which the baby is created, nullptr to allocate it with new.
          * @return The baby genome.
          */
-        Genome *give_me_baby(std::vector<std::shared_ptr<ConnectionHistory>> innovation_history);
+        Genome *give_me_baby(InnovationTracker &innovation_tracker, GenomeArena *arena = nullptr) const;
+
+        /**
+         * @brief Builds the selection table of the species, to be called once its genomes and their fitness are final.
+         * @param config NEAT configuration settings.
+         */
+        void prepare_selection(const Config &config);
+
+        /**
+         * @brief Computes the running sum of the selection weights of the genomes, for roulette and rank selections.
+         * Called by prepare_selection, before the babies of the species are made.
+         */
+        void update_cumulative_weights();
 
         /**
-         * @brief Selects a genome from the species based on its fitness.
+         * @brief Selects a genome from the species based on its fitness, with the strategy set by prepare_selection.
+         * Roulette and rank selections draw from the running sum of the weights with a binary search.
          * @return The selected genome.
+         * @throws std::logic_error If the genomes changed since the last call to prepare_selection.
          */
-        Genome *select_genome();
+        Genome *select_genome() const;
 
         /**
          * @brief Kills a part of the species based on a survival threshold.
@@ -107,8 +160,8 @@ namespace neat
         bool is_equal(Species *other);
 
         /**
-         * @brief Return a copy of this species.
-         * @return A copy of this species.
+         * @brief Return a copy of this species, sharing the same genomes.
+         * @return A copy of this species, owned by the caller.
          */
         Species *clone();
 
@@ -121,9 +174,11 @@ namespace neat
         /**
          * @brief Creates a species from a JSON object.
          * @param json JSON object representing the species.
-         * @return Species created from the JSON object.
+         * @param config Configuration of the genomes of the species.
+         * @param arena Arena in which the genomes of the species are created.
+         * @return Species created from the JSON object, owned by the caller.
          */
-        static Species *from_json(const nlohmann::json &json);
+        static Species *from_json(const nlohmann::json &json, const std::shared_ptr<const Config> &config, GenomeArena &arena);
 
         /**
          * @brief Save the species to a file.
@@ -134,9 +189,11 @@ namespace neat
         /**
          * @brief Load the species from a file.
          * @param file_path The path to the file.
-         * @return The loaded species.
+         * @param config Configuration of the genomes of the species.
+         * @param arena Arena in which the genomes of the species are created.
+         * @return The loaded species, owned by the caller.
          */
-        static Species *load(const std::string &file_path);
+        static Species *load(const std::string &file_path, const std::shared_ptr<const Config> &config, GenomeArena &arena);
     };
 }
 
@@ -0,0 +1,219 @@
+#include <numeric>
+#include <algorithm>
+#include "thread_pool.hpp"
+
+// Set on the worker threads of the pools, whose nested loops run inline
+static thread_local bool inside_pool = false;
+
+// Runs task(i) for each i in [0, count) on the calling thread, rethrowing the first exception at the end like a parallel loop
+static void run_inline(int count, const std::function<void(int)> &task)
+{
+    std::exception_ptr error;
+    for (int i = 0; i < count; ++i)
+    {
+        try
+        {
+            task(i);
+        }
+        catch (...)
+        {
+            if (!error)
+            {
+                error = std::current_exception();
+            }
+        }
+    }
+
+    if (error)
+    {
+        std::rethrow_exception(error);
+    }
+}
+
+neat::ThreadPool::ThreadPool(int nb_threads) : task(nullptr), busy_workers(0), loop_id(0), stopping(false)
+{
+    if (nb_threads <= 0)
+    {
+        nb_threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    for (int i = 0; i < nb_threads; ++i)
+    {
+        this->queues.push_back(std::make_unique<TaskQueue>());
+    }
+
+    for (int i = 0; i < nb_threads; ++i)
+    {
+        this->workers.emplace_back(&ThreadPool::worker_loop, this, i);
+    }
+}
+
+neat::ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        this->stopping = true;
+    }
+    this->work_available.notify_all();
+
+    for (auto &worker : this->workers)
+    {
+        worker.join();
+    }
+}
+
+int neat::ThreadPool::size() const
+{
+    return this->workers.size();
+}
+
+void neat::ThreadPool::parallel_for(int count, const std::function<void(int)> &task)
+{
+    if (count <= 0)
+    {
+        return;
+    }
+
+    if (inside_pool)
+    {
+        run_inline(count, task);
+        return;
+    }
+
+    std::lock_guard<std::mutex> loop_lock(this->loop_mutex);
+
+    // Give each worker a contiguous block of indices
+    for (int w = 0; w < this->size(); ++w)
+    {
+        int start = static_cast<long>(count) * w / this->size();
+        int end = static_cast<long>(count) * (w + 1) / this->size();
+        for (int i = start; i < end; ++i)
+        {
+            this->queues[w]->tasks.push_back(i);
+        }
+    }
+
+    this->run_loop(task);
+}
+
+void neat::ThreadPool::parallel_for(const std::vector<double> &costs, const std::function<void(int)> &task)
+{
+    if (costs.empty())
+    {
+        return;
+    }
+
+    if (inside_pool)
+    {
+        run_inline(costs.size(), task);
+        return;
+    }
+
+    std::lock_guard<std::mutex> loop_lock(this->loop_mutex);
+
+    // Deal the tasks round-robin from the most to the least expensive, so each queue is sorted largest first
+    std::vector<int> order(costs.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&](int i, int j)
+                     { return costs[i] > costs[j]; });
+
+    for (size_t i = 0; i < order.size(); ++i)
+    {
+        this->queues[i % this->size()]->tasks.push_back(order[i]);
+    }
+
+    this->run_loop(task);
+}
+
+void neat::ThreadPool::run_loop(const std::function<void(int)> &task)
+{
+    std::unique_lock<std::mutex> lock(this->mutex);
+    this->task = &task;
+    this->busy_workers = this->size();
+    this->error = nullptr;
+    ++this->loop_id;
+    this->work_available.notify_all();
+
+    // Wait for all the workers to be done with this loop
+    this->work_done.wait(lock, [this]
+                         { return this->busy_workers == 0; });
+    this->task = nullptr;
+
+    if (this->error)
+    {
+        std::rethrow_exception(this->error);
+    }
+}
+
+bool neat::ThreadPool::take_task(int worker_index, int &task_index)
+{
+    // Take the next task of the worker's own queue
+    {
+        TaskQueue &queue = *this->queues[worker_index];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (!queue.tasks.empty())
+        {
+            task_index = queue.tasks.front();
+            queue.tasks.pop_front();
+            return true;
+        }
+    }
+
+    // Otherwise steal the last task of another queue, which is the cheapest one
+    for (int i = 1; i < this->size(); ++i)
+    {
+        TaskQueue &queue = *this->queues[(worker_index + i) % this->size()];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (!queue.tasks.empty())
+        {
+            task_index = queue.tasks.back();
+            queue.tasks.pop_back();
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void neat::ThreadPool::worker_loop(int worker_index)
+{
+    inside_pool = true;
+    unsigned last_loop_id = 0;
+    while (true)
+    {
+        {
+            std::unique_lock<std::mutex> lock(this->mutex);
+            this->work_available.wait(lock, [&]
+                                      { return this->stopping || this->loop_id != last_loop_id; });
+            if (this->stopping)
+            {
+                return;
+            }
+            last_loop_id = this->loop_id;
+        }
+
+        // Run tasks until all the queues are empty; no task is added during a loop, so none can be missed
+        int task_index;
+        while (this->take_task(worker_index, task_index))
+        {
+            try
+            {
+                (*this->task)(task_index);
+            }
+            catch (...)
+            {
+                std::lock_guard<std::mutex> lock(this->mutex);
+                if (!this->error)
+                {
+                    this->error = std::current_exception();
+                }
+            }
+        }
+
+        std::lock_guard<std::mutex> lock(this->mutex);
+        if (--this->busy_workers == 0)
+        {
+            this->work_done.notify_one();
+        }
+    }
+}
@@ -0,0 +1,116 @@
+#ifndef NEAT_THREAD_POOL_HPP
+#define NEAT_THREAD_POOL_HPP
+
+#include <deque>
+#include <memory>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <functional>
+#include <exception>
+#include <condition_variable>
+
+namespace neat
+{
+
+    /**
+     * @brief Persistent pool of worker threads running parallel loops.
+     *
+     * The workers are created once and sleep between two calls to parallel_for, so running a loop doesn't create any thread.
+     * Each worker has its own queue of tasks and steals from the other queues once its own is empty, so the workers stay
+     * busy until the end of the loop even when the tasks have very different costs.
+     *
+     * The pool runs one loop at a time: if several threads call parallel_for, their loops run one after the other.
+     * A parallel_for called from a task, e.g. by an evaluator calling back into the population, runs inline on the
+     * calling worker, since waiting for the other workers could deadlock.
+     */
+    class ThreadPool
+    {
+    public:
+        /**
+         * @brief Constructor for the ThreadPool class.
+         * @param nb_threads Number of worker threads, 0 to use one per hardware thread.
+         */
+        ThreadPool(int nb_threads = 0);
+
+        /**
+         * @brief Destructor for the ThreadPool class, waits for the workers to stop.
+         */
+        ~ThreadPool();
+
+        ThreadPool(const ThreadPool &) = delete;
+        ThreadPool &operator=(const ThreadPool &) = delete;
+
+        /**
+         * @brief Returns the number of worker threads.
+         * @return Number of worker threads.
+         */
+        int size() const;
+
+        /**
+         * @brief Runs task(i) for each i in [0, count) on the workers and waits for all of them to finish.
+         * Each worker starts with a contiguous block of indices.
+         * If a task throws, the first exception is rethrown once the loop is over.
+         * @param count Number of tasks.
+         * @param task Function called with the index of each task.
+         */
+        void parallel_for(int count, const std::function<void(int)> &task);
+
+        /**
+         * @brief Runs task(i) for each i in [0, costs.size()) on the workers and waits for all of them to finish.
+         * The tasks are dealt to the workers from the most to the least expensive, so the cheap ones are left to fill the
+         * gaps at the end of the loop.
+         * If a task throws, the first exception is rethrown once the loop is over.
+         * @param costs Estimated cost of each task, only their order matters.
+         * @param task Function called with the index of each task.
+         */
+        void parallel_for(const std::vector<double> &costs, const std::function<void(int)> &task);
+
+    private:
+        /**
+         * @brief Tasks waiting to be run by a worker.
+         */
+        struct TaskQueue
+        {
+            std::mutex mutex;
+            std::deque<int> tasks; // The owner takes from the front, thieves from the back.
+        };
+
+        std::vector<std::thread> workers;
+        std::vector<std::unique_ptr<TaskQueue>> queues; // One queue per worker.
+        std::mutex loop_mutex;                          // Held by the thread running a loop, so the loops don't overlap.
+        std::mutex mutex;
+        std::condition_variable work_available;
+        std::condition_variable work_done;
+
+        // State of the current loop
+        const std::function<void(int)> *task; // Function of the current loop.
+        int busy_workers;                     // Number of workers still working on the current loop.
+        unsigned loop_id;                     // Incremented for each loop, so that workers notice new work.
+        std::exception_ptr error;             // First exception thrown by a task.
+        bool stopping;                        // Set when the pool is destroyed.
+
+        /**
+         * @brief Starts a loop over the tasks already placed in the queues and waits for it to finish.
+         * @param task Function called with the index of each task.
+         */
+        void run_loop(const std::function<void(int)> &task);
+
+        /**
+         * @brief Takes the next task of a worker, from its own queue or stolen from another one.
+         * @param worker_index Index of the worker.
+         * @param task_index Set to the index of the task taken.
+         * @return True if a task was taken, false if all the queues are empty.
+         */
+        bool take_task(int worker_index, int &task_index);
+
+        /**
+         * @brief Main loop of a worker thread.
+         * @param worker_index Index of the worker.
+         */
+        void worker_loop(int worker_index);
+    };
+
+}
+
+#endif
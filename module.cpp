@@ -4,8 +4,10 @@
 #include "pybind11/stl.h"
 #include <thread>
 #include "lib/config.hpp"
+#include "lib/math_utils.hpp"
 #include "lib/population.hpp"
 #include "lib/genome.hpp"
+#include "lib/compiled_network.hpp"
 
 namespace py = pybind11;
 namespace neat_cpp = neat;
@@ -26,8 +28,12 @@ PYBIND11_MODULE(neat, m)
                      return py::cast(config.no_fitness_termination);
                  else if (key == "reset_on_extinction")
                      return py::cast(config.reset_on_extinction);
+                 else if (key == "num_threads")
+                     return py::cast(config.num_threads);
+                 else if (key == "fitness_cache")
+                     return py::cast(config.fitness_cache);
                  else if (key == "activation_default")
-                     return py::cast(config.activation_default);
+                     return py::cast(neat_cpp::activation_function_to_string(config.activation_default));
                  else if (key == "activation_mutate_rate")
                      return py::cast(config.activation_mutate_rate);
                  else if (key == "num_inputs")
@@ -47,7 +53,7 @@ PYBIND11_MODULE(neat, m)
                  else if (key == "enabled_mutate_rate")
                      return py::cast(config.enabled_mutate_rate);
                  else if (key == "initial_connections")
-                     return py::cast(config.initial_connections);
+                     return py::cast(neat_cpp::initial_connection_to_string(config.initial_connections));
                  else if (key == "node_add_prob")
                      return py::cast(config.node_add_prob);
                  else if (key == "node_delete_prob")
@@ -57,7 +63,7 @@ PYBIND11_MODULE(neat, m)
                  else if (key == "weight_init_stdev")
                      return py::cast(config.weight_init_stdev);
                  else if (key == "weight_init_type")
-                     return py::cast(config.weight_init_type);
+                     return py::cast(neat_cpp::distribution_type_to_string(config.weight_init_type));
                  else if (key == "weight_max_value")
                      return py::cast(config.weight_max_value);
                  else if (key == "weight_min_value")
@@ -76,6 +82,10 @@ PYBIND11_MODULE(neat, m)
                      return py::cast(config.survival_threshold);
                  else if (key == "min_species_size")
                      return py::cast(config.min_species_size);
+                 else if (key == "selection_type")
+                     return py::cast(neat_cpp::selection_type_to_string(config.selection_type));
+                 else if (key == "tournament_size")
+                     return py::cast(config.tournament_size);
                  else if (key == "compatibility_threshold")
                      return py::cast(config.compatibility_threshold);
                  else if (key == "bad_species_threshold")
@@ -93,8 +103,12 @@ PYBIND11_MODULE(neat, m)
                     config.no_fitness_termination = value.cast<decltype(config.no_fitness_termination)>();
                 else if (key == "reset_on_extinction")
                     config.reset_on_extinction = value.cast<decltype(config.reset_on_extinction)>();
+                else if (key == "num_threads")
+                    config.num_threads = value.cast<decltype(config.num_threads)>();
+                else if (key == "fitness_cache")
+                    config.fitness_cache = value.cast<decltype(config.fitness_cache)>();
                 else if (key == "activation_default")
-                    config.activation_default = value.cast<decltype(config.activation_default)>();
+                    config.activation_default = neat_cpp::activation_function_from_string(value.cast<std::string>());
                 else if (key == "activation_mutate_rate")
                     config.activation_mutate_rate = value.cast<decltype(config.activation_mutate_rate)>();
                 else if (key == "num_inputs")
@@ -114,7 +128,7 @@ PYBIND11_MODULE(neat, m)
                 else if (key == "enabled_mutate_rate")
                     config.enabled_mutate_rate = value.cast<decltype(config.enabled_mutate_rate)>();
                 else if (key == "initial_connections")
-                    config.initial_connections = value.cast<decltype(config.initial_connections)>();
+                    config.initial_connections = neat_cpp::initial_connection_from_string(value.cast<std::string>());
                 else if (key == "node_add_prob")
                     config.node_add_prob = value.cast<decltype(config.node_add_prob)>();
                 else if (key == "node_delete_prob")
@@ -124,7 +138,7 @@ PYBIND11_MODULE(neat, m)
                 else if (key == "weight_init_stdev")
                     config.weight_init_stdev = value.cast<decltype(config.weight_init_stdev)>();
                 else if (key == "weight_init_type")
-                    config.weight_init_type = value.cast<decltype(config.weight_init_type)>(); 
+                    config.weight_init_type = neat_cpp::distribution_type_from_string(value.cast<std::string>());
                 else if (key == "weight_max_value") 
                     config.weight_max_value = value.cast<decltype(config.weight_max_value)>();
                 else if (key == "weight_min_value")
@@ -143,6 +157,10 @@ PYBIND11_MODULE(neat, m)
                     config.survival_threshold = value.cast<decltype(config.survival_threshold)>();
                 else if (key == "min_species_size")
                     config.min_species_size = value.cast<decltype(config.min_species_size)>();
+                else if (key == "selection_type")
+                    config.selection_type = neat_cpp::selection_type_from_string(value.cast<std::string>());
+                else if (key == "tournament_size")
+                    config.tournament_size = value.cast<decltype(config.tournament_size)>();
                 else if (key == "compatibility_threshold")
                     config.compatibility_threshold = value.cast<decltype(config.compatibility_threshold)>();
                 else if (key == "bad_species_threshold")
@@ -151,22 +169,45 @@ PYBIND11_MODULE(neat, m)
                     throw std::invalid_argument("Invalid key"); });
 
     m.def("load_config", &neat_cpp::load_config, "Loads NEAT configuration from a file.");
+    m.def("seed", &neat_cpp::seed, "Seeds the random number generation of every thread.");
+    m.def("seed_thread", &neat_cpp::seed_thread, "Seeds the random number generation of the calling thread only.");
 
     py::class_<neat_cpp::Population>(m, "Population")
         .def(py::init<const neat_cpp::Config &>())
         .def_readonly("generation", &neat_cpp::Population::generation, "Current generation number.")
         .def_readonly("best_fitness", &neat_cpp::Population::best_fitness, "Fitness of the best genome.")
         .def_readonly("average_fitness", &neat_cpp::Population::average_fitness, "Average fitness of the population.")
-        .def_readonly("best_genome", &neat_cpp::Population::best_genome, "Best genome in the population.")
-        .def_readonly("genomes", &neat_cpp::Population::genomes, "List of genomes in the population.")
-        .def("run", &neat_cpp::Population::run, py::call_guard<py::gil_scoped_release>(), "Runs the NEAT algorithm for a specified number of generations.");
+        .def_property_readonly("best_genome", [](const neat_cpp::Population &population)
+                               { return population.best_genome.get(); }, py::return_value_policy::reference_internal, "Best genome in the population.")
+        .def_readonly("genomes", &neat_cpp::Population::genomes, "List of genomes in the population, only valid for two generations as their storage is then reused.")
+        .def("clone_genomes", [](neat_cpp::Population &population)
+             {
+                 py::list genomes;
+                 for (auto genome : population.genomes)
+                 {
+                     genomes.append(py::cast(genome->clone(), py::return_value_policy::take_ownership));
+                 }
+                 return genomes; }, "Returns copies of the genomes in the population, which stay valid after the next generations.")
+        .def_property_readonly("config", [](const neat_cpp::Population &population)
+                               { return *population.config; }, "Configuration settings of the population (a copy).")
+        .def("set_config", &neat_cpp::Population::set_config, "Replaces the configuration of the population, applied from the next generation.")
+        .def_readwrite("seed", &neat_cpp::Population::seed, "Seed of the run, from which the random stream of each genome is derived.")
+        .def("run", &neat_cpp::Population::run, py::call_guard<py::gil_scoped_release>(), "Runs the NEAT algorithm for a specified number of generations.")
+        .def("run_batched", &neat_cpp::Population::run_batched, py::call_guard<py::gil_scoped_release>(), "Runs the NEAT algorithm, evaluating all the genomes of a generation with a single call.");
 
     py::class_<neat::Genome>(m, "Genome")
         .def(py::init<const neat_cpp::Config &, bool>())
         .def_readonly("id", &neat_cpp::Genome::id, "Unique identifier for the genome.")
         .def_readwrite("fitness", &neat_cpp::Genome::fitness, "Fitness score of the genome.")
         .def("feed_forward", &neat_cpp::Genome::feed_forward, "Performs a feed-forward operation on the neural network.")
+        .def("hash", &neat_cpp::Genome::hash, "Hash of the structure and weights of the genome.")
         .def("print", &neat_cpp::Genome::print, "Print the genome's structure.")
         .def("save", &neat_cpp::Genome::save, "Saves the genome to a binary file.")
-        .def_static("load", &neat_cpp::Genome::load, "Loads the genome from a binary file.");
+        .def_static("load", [](const std::string &file_path)
+                    { return neat_cpp::Genome::load(file_path); }, "Loads the genome from a binary file.");
+
+    py::class_<neat_cpp::CompiledNetwork>(m, "CompiledNetwork")
+        .def(py::init<const neat_cpp::Genome &>())
+        .def("feed_forward", &neat_cpp::CompiledNetwork::feed_forward, "Performs a feed-forward operation on the compiled network.")
+        .def("feed_forward_batch", py::overload_cast<const std::vector<double> &>(&neat_cpp::CompiledNetwork::feed_forward_batch, py::const_), "Performs a feed-forward operation on a row-major batch of inputs.");
 }
\ No newline at end of file
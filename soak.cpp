@@ -0,0 +1,87 @@
+#include <iostream>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+#include <cmath>
+#include <sys/resource.h>
+#include "lib/math_utils.hpp"
+#include "lib/config.hpp"
+#include "lib/genome.hpp"
+#include "lib/population.hpp"
+
+// Soak test of the genome arenas: once the size of the genomes is fixed, running thousands of generations
+// must not raise the peak memory of the process, and the arenas must keep recycling the same genomes.
+
+int expected = 10;
+std::vector<double> inputs = {1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16, 17, 18, 19, 20};
+
+void evaluate_genome(neat::Genome *g, int generation)
+{
+    std::vector<double> result = g->feed_forward(inputs);
+    g->fitness = 1 / (1e-9 + std::abs(expected - result[0]));
+}
+
+// Peak resident set size of the process, in kB
+long peak_memory()
+{
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+#ifdef __APPLE__
+    return usage.ru_maxrss / 1024;
+#else
+    return usage.ru_maxrss;
+#endif
+}
+
+// Number of genomes alive in the arenas of the population
+int arenas_capacity(neat::Population *p)
+{
+    return p->genome_arenas[0].capacity() + p->genome_arenas[1].capacity();
+}
+
+int main(int argc, char *argv[])
+{
+    int warmup_generations = 200;
+    int generations = argc > 1 ? std::atoi(argv[1]) : 5000;
+    double tolerance = 0.05; // Allowed growth of the peak memory after the warm-up
+
+    neat::seed(1);
+    neat::Config config = neat::load_config("default_config.txt");
+    neat::Population *p = new neat::Population(config);
+
+    // Let the networks grow for a while, then stop structural mutations so that the genomes keep their size
+    p->run(&evaluate_genome, warmup_generations);
+    config.node_add_prob = 0;
+    config.node_delete_prob = 0;
+    config.conn_add_prob = 0;
+    config.conn_delete_prob = 0;
+    p->set_config(config);
+    p->run(&evaluate_genome, warmup_generations);
+
+    long warmup_peak = peak_memory();
+    int warmup_capacity = arenas_capacity(p);
+    printf("After warm-up: peak memory %ld kB, %d genomes in the arenas\n", warmup_peak, warmup_capacity);
+
+    int step = std::max(1, generations / 10);
+    p->run(&evaluate_genome, generations, [&](neat::Population *p, int generation)
+           {
+               if ((generation + 1) % step == 0)
+               {
+                   printf("Generation %d: peak memory %ld kB, %d genomes in the arenas\n", generation + 1, peak_memory(), arenas_capacity(p));
+               } });
+
+    long final_peak = peak_memory();
+    int final_capacity = arenas_capacity(p);
+    delete p;
+
+    // Each arena holds at most a generation, plus the genomes created by reset_on_extinction
+    int max_capacity = 4 * config.population_size;
+    if (final_capacity > max_capacity || final_peak > warmup_peak * (1 + tolerance))
+    {
+        printf("FAILED: peak memory went from %ld kB to %ld kB, arenas from %d to %d genomes (at most %d)\n", warmup_peak, final_peak, warmup_capacity, final_capacity, max_capacity);
+        return 1;
+    }
+
+    printf("PASSED: peak memory stayed flat over %d generations\n", generations);
+    return 0;
+}